@@ -0,0 +1,214 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                         *
+ * alias.cpp                                               *
+ *                                                         *
+ * Contains implementation of Disambiguator class.         *
+ *                                                         *
+ * Memory operations at known addresses are grouped into   *
+ * a Slot per address. A store waits for the last store    *
+ * and the reads since then at every address it overlaps; *
+ * a read waits only for those stores. A store to an       *
+ * unknown address waits for everything before it and     *
+ * starts over with no Slots (it is the barrier), and a    *
+ * load from an unknown address waits for every store      *
+ * since the barrier. Outputs are reads that also stay in  *
+ * program order with each other.                          *
+ *                                                         *
+ * Written by: Austin James Lee                            *
+ *                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "alias.h"
+
+
+// Slot constructor
+Disambiguator::Slot::Slot() :store{INVALID} {}
+
+
+// Disambiguator constructor
+Disambiguator::Disambiguator(const Scheduler& s)
+		:baselineEdges{0}, baselinePath{0}, s{s},
+		known(s.numVRs, 0), value(s.numVRs, 0), unaligned{false},
+		barrier{INVALID}, lastOutput{INVALID}, depth(s.nodes.size(), 0),
+		lastStore{INVALID}, loads{0}, loadDepth{0} {}
+
+
+// appends the serialization dependences of Node n to
+// deps, which holds its register dependences.
+void Disambiguator::serialize(int n, vector<int>& deps) {
+	const Instruction& in = s.nodes[n];
+	const int* v = &s.vr[NumOperands * n];
+	baseline(n, deps);
+
+	switch (in.op) {
+		case output:
+			if (lastOutput != INVALID)
+				deps.push_back(lastOutput);
+			lastOutput = n;
+			// fall through: an output reads its address
+		case load: {
+			bool direct = in.op == output || known[v[Src1]];
+			int addr = in.op == output ? in.operand[Src1] : value[v[Src1]];
+			bool ordered = false;	// depends on a store since barrier
+			if (direct) {
+				ordered = aliases(addr, deps, false);
+				slots[addr].reads.push_back(n);
+			} else {
+				for (auto& a : slots)
+					if (a.second.store != INVALID) {
+						deps.push_back(a.second.store);
+						ordered = true;
+					}
+				unknownReads.push_back(n);
+			}
+			if (!ordered && barrier != INVALID)
+				deps.push_back(barrier);
+			break;
+		}
+		case store: {
+			bool ordered = false;
+			deps.insert(deps.end(), unknownReads.begin(), unknownReads.end());
+			if (known[v[Src2]]) {
+				int addr = value[v[Src2]];
+				ordered = aliases(addr, deps, true);
+				Slot& slot = slots[addr];
+				slot.store = n;
+				slot.reads.clear();
+			} else {
+				for (auto& a : slots) {
+					if (a.second.store != INVALID) {
+						deps.push_back(a.second.store);
+						ordered = true;
+					}
+					deps.insert(deps.end(), a.second.reads.begin(),
+						a.second.reads.end());
+				}
+				slots.clear();
+				unknownReads.clear();
+				unaligned = false;
+			}
+			if (!ordered && barrier != INVALID)
+				deps.push_back(barrier);
+			if (!known[v[Src2]])
+				barrier = n;
+			break;
+		}
+		default:
+			break;
+	}
+
+	define(n);
+}
+
+
+//// private Disambiguator methods ////
+
+
+// records the value Node n defines, if it is known.
+// every VR has one definition, so a value never
+// has to be forgotten.
+void Disambiguator::define(int n) {
+	const Instruction& in = s.nodes[n];
+	const int* v = &s.vr[NumOperands * n];
+	if (!in.isReg(Dest))
+		return;
+	if (in.op == loadI) {
+		known[v[Dest]] = 1;
+		value[v[Dest]] = in.operand[Src1];
+		return;
+	}
+	if (in.op != add && in.op != sub && in.op != lshift)
+		return;
+	if (!known[v[Src1]] || !known[v[Src2]])
+		return;
+
+	// wrap around like the machine does
+	unsigned a = value[v[Src1]], b = value[v[Src2]];
+	switch (in.op) {
+		case add:
+			value[v[Dest]] = a + b;
+			break;
+		case sub:
+			value[v[Dest]] = a - b;
+			break;
+		default:
+			if (b >= 32)
+				return;
+			value[v[Dest]] = a << b;
+			break;
+	}
+	known[v[Dest]] = 1;
+}
+
+
+// appends the last store to every Slot whose word overlaps
+// the word at addr, and, if writing, the reads since then.
+// returns whether any such store was found.
+bool Disambiguator::aliases(int addr, vector<int>& deps, bool writing) {
+	bool found = false;
+	if (addr % WORD_SIZE)
+		unaligned = true;
+	// aligned words overlap only when they are equal
+	int reach = unaligned ? WORD_SIZE - 1 : 0;
+	for (int d = -reach; d <= reach; ++d) {
+		auto a = slots.find((int)((unsigned)addr + d));
+		if (a == slots.end())
+			continue;
+		if (a->second.store != INVALID) {
+			deps.push_back(a->second.store);
+			found = true;
+		}
+		if (writing)
+			deps.insert(deps.end(), a->second.reads.begin(),
+				a->second.reads.end());
+	}
+	return found;
+}
+
+
+// counts the serialization edges buildDepGraph adds without
+// disambiguation, and the distance they put between Node n
+// and a leaf, given n's register dependences in deps.
+void Disambiguator::baseline(int n, const vector<int>& deps) {
+	int op = s.nodes[n].op;
+	int path = 0;
+	long regLoads = 0;	// loads among deps, which stores already count
+	for (size_t d = 0; d < deps.size(); ++d) {
+		path = max(path, depth[deps[d]]);
+		if (s.nodes[deps[d]].op == load && (d == 0 || deps[d] != deps[0]))
+			++regLoads;
+	}
+
+	switch (op) {
+		case load:
+			if (lastStore != INVALID) {
+				++baselineEdges;
+				path = max(path, depth[lastStore]);
+			}
+			break;
+		case store:
+			baselineEdges += loads - regLoads;
+			path = max(path, loadDepth);
+			// fall through
+		case output:
+			if (lastStore != INVALID) {
+				++baselineEdges;
+				path = max(path, depth[lastStore]);
+			}
+			if (lastOutput != INVALID) {
+				++baselineEdges;
+				path = max(path, depth[lastOutput]);
+			}
+			break;
+		default:
+			break;
+	}
+
+	depth[n] = path + Scheduler::latency((Opcode)op);
+	baselinePath = max(baselinePath, depth[n]);
+	if (op == load) {
+		++loads;
+		loadDepth = max(loadDepth, depth[n]);
+	} else if (op == store)
+		lastStore = n;
+}
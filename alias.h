@@ -0,0 +1,71 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                         *
+ * alias.h                                                 *
+ *                                                         *
+ * Contains declaration for Disambiguator class, which     *
+ * tracks the addresses memory operations touch so that    *
+ * buildDepGraph need only serialize operations that may   *
+ * alias, as well as all necessary includes and using      *
+ * statements not already present in scheduler.h.          *
+ *                                                         *
+ * Written by: Austin James Lee                            *
+ *                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+
+#include "scheduler.h"
+#include <unordered_map>
+
+#define WORD_SIZE 4		// bytes read or written by a memory operation
+
+using std::unordered_map;
+
+
+//// Disambiguator class ////
+
+// walks a block's Nodes in order alongside buildDepGraph.
+// the value of a register is known when it comes from
+// loadI, or from add, sub or lshift of known values; two
+// memory operations may alias unless both addresses are
+// known and lie a whole word apart. an operation whose
+// address is unknown may alias anything.
+class Disambiguator {
+	public:
+		// takes the renamed block being built
+		Disambiguator(const Scheduler& s);
+		// given the register dependences of Node n in deps,
+		// appends its serialization dependences and records
+		// what n provides to later Nodes. Nodes must be
+		// visited in order.
+		void serialize(int n, vector<int>& deps);
+		// what the conservative rules (each store ordered after
+		// every earlier memory operation, each load and output
+		// after the last store) would have produced
+		long baselineEdges;		// serialization edges
+		int baselinePath;		// length of the critical path
+	private:
+		// memory operations at one known address since the
+		// last store to an unknown address
+		struct Slot {
+			Slot();
+			int store;			// last store to this address
+			vector<int> reads;	// loads and outputs since that store
+		};
+		const Scheduler& s;
+		vector<char> known;		// VR holds a known value
+		vector<int> value;		// that value
+		unordered_map<int, Slot> slots;	// address -> Slot
+		bool unaligned;			// some address in slots is not word aligned
+		int barrier;			// last store to an unknown address
+		vector<int> unknownReads;	// loads of unknown addresses since barrier
+		int lastOutput;
+		// state of the conservative rules
+		vector<int> depth;		// latency-weighted distance to a leaf
+		int lastStore;
+		long loads;				// loads so far
+		int loadDepth;			// deepest load so far
+		void define(int n);
+		void baseline(int n, const vector<int>& deps);
+		bool aliases(int addr, vector<int>& deps, bool writing);
+};
@@ -0,0 +1,338 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                         *
+ * allocator.cpp                                           *
+ *                                                         *
+ * Contains implementation of Allocator class.             *
+ *                                                         *
+ * Values are allocated bundle by bundle, in the order     *
+ * they issue. When no register is free, the value whose   *
+ * next use is furthest away is evicted. Values defined by *
+ * loadI are recomputed rather than stored, and a value    *
+ * that already has a copy in memory is never stored       *
+ * twice, since every VR has exactly one definition.       *
+ *                                                         *
+ * Written by: Austin James Lee                            *
+ *                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "allocator.h"
+
+
+// Allocator constructor.
+//
+// allocates the cycles of s's schedule, or each Node in
+// order if s was not scheduled. one register is set aside
+// to hold spill addresses, but only when some value has
+// to be stored or reloaded. values live on entry start in
+// the registers they arrive in, so those must exist (and
+// not be the one set aside); otherwise error says why.
+Allocator::Allocator(Scheduler& s, int k, const Machine& m)
+		:s{s}, k{k}, m{m} {
+	Clock::time_point start = Clock::now();
+
+	bundled = s.width > 0;
+	width = bundled ? s.width : 1;
+	if (bundled)
+		order = s.slots;
+	else
+		for (int n = 0; n < (int)s.nodes.size(); ++n)
+			order.push_back(n);
+
+	computeNextUses();
+	int highest = INVALID;
+	for (int sr : liveIn)
+		highest = max(highest, sr);
+	if (highest >= k)
+		error = "r" + std::to_string(highest) + " is live on entry, so "
+			"at least " + std::to_string(highest + 1) + " registers are needed";
+	else if (!run(false) && error.empty()) {
+		if (highest >= k - 1)
+			error = "r" + std::to_string(highest) + " is live on entry and "
+				"spilling needs a register above it, so at least "
+				+ std::to_string(highest + 2) + " registers are needed";
+		else
+			run(true);
+	}
+	if (!error.empty())
+		code.clear();
+
+	s.registers = k;
+	s.allocCycles = code.size() / width;
+	s.lap(AllocatePhase, start);
+}
+
+
+// prints the allocated code. scheduled code prints
+// one cycle per line as "[ op1 ; op2 ]", as the
+// schedule does; otherwise one operation per line.
+void Allocator::print(ostream& os) const {
+	Emitter out {os};
+	for (size_t c = 0; c < code.size(); c += width) {
+		if (bundled)
+			out.put("[ ");
+		for (int u = 0; u < width; ++u) {
+			if (u)
+				out.put(" ; ");
+			out.iloc(code[c + u]);
+		}
+		out.put(bundled ? " ]\n" : "\n");
+	}
+}
+
+
+// sets nextUse of every operand to the index of the
+// next bundle that reads its VR, or NO_USE. operands read
+// within one bundle all see the next bundle after it.
+// also finds the VRs no Node defines, which are live on
+// entry in the registers their readers name.
+void Allocator::computeNextUses() {
+	vector<int>& next = firstUse;
+	next.assign(s.numVRs, NO_USE);
+	nextUse.assign(s.vr.size(), NO_USE);
+	liveIn.assign(s.numVRs, INVALID);
+	vector<bool> defined (s.numVRs, false);
+
+	for (int c = order.size() - width; c >= 0; c -= width) {
+		int bundle = c / width;
+		for (int u = 0; u < width; ++u) {
+			int n = order[c + u];
+			if (n == INVALID)
+				continue;
+			for (int o = Src1; o < NumOperands; ++o)
+				if (s.nodes[n].isReg(o))
+					nextUse[NumOperands * n + o] =
+						next[s.vr[NumOperands * n + o]];
+		}
+		for (int u = 0; u < width; ++u) {
+			int n = order[c + u];
+			if (n == INVALID)
+				continue;
+			for (int o = Src1; o < Dest; ++o)
+				if (s.nodes[n].isReg(o)) {
+					next[s.vr[NumOperands * n + o]] = bundle;
+					liveIn[s.vr[NumOperands * n + o]] = s.nodes[n].operand[o];
+				}
+			if (s.nodes[n].isReg(Dest))
+				defined[s.vr[NumOperands * n + Dest]] = true;
+		}
+	}
+	for (int vr = 0; vr < s.numVRs; ++vr)
+		if (defined[vr])
+			liveIn[vr] = INVALID;
+}
+
+
+// allocates every bundle. sources are brought into
+// registers first and pinned so no other source of the
+// bundle can evict them; sources read for the last time
+// are then freed, so a destination may reuse them.
+//
+// returns false if a value had to be stored or reloaded
+// while no register was reserved for spill addresses.
+bool Allocator::run(bool reserve) {
+	int avail = reserve ? k - 1 : k;
+	reserved = reserve ? k - 1 : INVALID;
+	nextSpill = SPILL_BASE;
+	vrToPr.assign(s.numVRs, INVALID);
+	spillAddr.assign(s.numVRs, INVALID);
+	remat.assign(s.numVRs, false);
+	rematValue.assign(s.numVRs, 0);
+	prToVr.assign(avail, INVALID);
+	prNext.assign(avail, NO_USE);
+	prFreeAt.assign(avail, 0);
+	pinned.assign(avail, false);
+	physical.assign(s.vr.size(), INVALID);
+	code.clear();
+	s.spillStores = s.spillLoads = s.remats = 0;
+
+	// values live on entry are already in their registers
+	for (int vr = 0; vr < s.numVRs; ++vr)
+		if (liveIn[vr] != INVALID)
+			assign(vr, liveIn[vr], firstUse[vr]);
+
+	for (b = 0; b * width < (int)order.size(); ++b) {
+		int c = b * width;
+
+		// sources
+		for (int u = 0; u < width; ++u) {
+			int n = order[c + u];
+			if (n == INVALID)
+				continue;
+			for (int o = Src1; o < Dest; ++o) {
+				int i = NumOperands * n + o;
+				if (!s.nodes[n].isReg(o))
+					continue;
+				int pr = vrToPr[s.vr[i]];
+				if (pr == INVALID &&
+						(!getPR(pr) || !restore(s.vr[i], pr)))
+					return false;
+				assign(s.vr[i], pr, nextUse[i]);
+				pinned[pr] = true;
+				physical[i] = pr;
+			}
+		}
+
+		// free sources read for the last time
+		for (int u = 0; u < width; ++u) {
+			int n = order[c + u];
+			if (n == INVALID)
+				continue;
+			for (int o = Src1; o < Dest; ++o) {
+				int i = NumOperands * n + o;
+				if (s.nodes[n].isReg(o) && nextUse[i] == NO_USE &&
+						vrToPr[s.vr[i]] != INVALID) {
+					prToVr[physical[i]] = INVALID;
+					vrToPr[s.vr[i]] = INVALID;
+				}
+			}
+		}
+		pinned.assign(avail, false);
+
+		// destinations. a value never read keeps its register
+		// until its write has landed.
+		for (int u = 0; u < width; ++u) {
+			int n = order[c + u];
+			if (n == INVALID || !s.nodes[n].isReg(Dest))
+				continue;
+			const Instruction& in = s.nodes[n];
+			int i = NumOperands * n + Dest;
+			int pr;
+			if (!getPR(pr))
+				return false;
+			assign(s.vr[i], pr, nextUse[i]);
+			pinned[pr] = true;
+			physical[i] = pr;
+			if (in.op == loadI) {
+				remat[s.vr[i]] = true;
+				rematValue[s.vr[i]] = in.operand[Src1];
+			}
+			if (nextUse[i] == NO_USE) {
+				prToVr[pr] = INVALID;
+				vrToPr[s.vr[i]] = INVALID;
+				prFreeAt[pr] = b + Scheduler::latency((Opcode)in.op);
+			}
+		}
+		pinned.assign(avail, false);
+
+		for (int u = 0; u < width; ++u)
+			code.push_back(order[c + u] == INVALID ?
+				Instruction {nop} : copy(order[c + u]));
+	}
+	return true;
+}
+
+
+// finds a register for a value. prefers a free one;
+// otherwise evicts the unpinned value used furthest in
+// the future, favouring values that need no store. if
+// every candidate is still waiting on a dead write, idles
+// until the earliest such write has landed. if every
+// register is pinned, sets error and returns false.
+bool Allocator::getPR(int& pr) {
+	int avail = prToVr.size();
+	for (pr = 0; pr < avail; ++pr)
+		if (prToVr[pr] == INVALID && prFreeAt[pr] <= b)
+			return true;
+
+	int victim = INVALID;
+	for (int p = 0; p < avail; ++p) {
+		if (prToVr[p] == INVALID || pinned[p])
+			continue;
+		if (victim == INVALID || prNext[p] > prNext[victim] ||
+				(prNext[p] == prNext[victim] && clean(p) && !clean(victim)))
+			victim = p;
+	}
+	if (victim != INVALID) {
+		pr = victim;
+		return spill(victim);
+	}
+
+	for (int p = 0; p < avail; ++p)
+		if (prToVr[p] == INVALID && !pinned[p] &&
+				(victim == INVALID || prFreeAt[p] < prFreeAt[victim]))
+			victim = p;
+	if (victim == INVALID) {
+		error = "a cycle needs more than " + std::to_string(avail)
+			+ " registers at once";
+		return false;
+	}
+	for (int c = b; c < prFreeAt[victim]; ++c)
+		emit(Instruction {nop});
+	prFreeAt[victim] = 0;
+	pr = victim;
+	return true;
+}
+
+
+// true when evicting the value in pr needs no store
+bool Allocator::clean(int pr) const {
+	int vr = prToVr[pr];
+	return remat[vr] || spillAddr[vr] != INVALID;
+}
+
+
+// evicts the value held in pr, storing it to a fresh
+// spill address unless it can be recomputed or already
+// has a copy in memory.
+bool Allocator::spill(int pr) {
+	int vr = prToVr[pr];
+	if (!clean(pr)) {
+		if (reserved == INVALID)
+			return false;
+		spillAddr[vr] = nextSpill;
+		nextSpill += 4;
+		emit(Instruction {loadI, spillAddr[vr], INVALID, reserved});
+		emit(Instruction {store, pr, reserved});
+		++s.spillStores;
+	}
+	prToVr[pr] = INVALID;
+	vrToPr[vr] = INVALID;
+	return true;
+}
+
+
+// brings vr back into pr, by loadI if it was defined by
+// loadI and by load from its spill address otherwise.
+bool Allocator::restore(int vr, int pr) {
+	if (remat[vr]) {
+		emit(Instruction {loadI, rematValue[vr], INVALID, pr});
+		++s.remats;
+	} else if (spillAddr[vr] != INVALID) {
+		if (reserved == INVALID)
+			return false;
+		emit(Instruction {loadI, spillAddr[vr], INVALID, reserved});
+		emit(Instruction {load, reserved, INVALID, pr});
+		++s.spillLoads;
+	}
+	return true;
+}
+
+
+// adds a cycle holding only i, on the first
+// unit i may issue on.
+void Allocator::emit(const Instruction& i) {
+	int unit = 0;
+	while (!(m.units[i.op] >> unit & 1) && unit + 1 < width)
+		++unit;
+	for (int u = 0; u < width; ++u)
+		code.push_back(u == unit ? i : Instruction {nop});
+}
+
+
+// records that vr, next used in bundle nu, lives in pr
+void Allocator::assign(int vr, int pr, int nu) {
+	vrToPr[vr] = pr;
+	prToVr[pr] = vr;
+	prNext[pr] = nu;
+}
+
+
+// returns a copy of Node n whose register
+// operands name their physical registers.
+Instruction Allocator::copy(int n) const {
+	Instruction in = s.nodes[n];
+	for (int o = Src1; o < NumOperands; ++o)
+		if (in.isReg(o))
+			in.operand[o] = physical[NumOperands * n + o];
+	return in;
+}
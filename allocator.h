@@ -0,0 +1,69 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                         *
+ * allocator.h                                             *
+ *                                                         *
+ * Contains declaration for Allocator class, a bottom-up   *
+ * local register allocator that maps the virtual          *
+ * registers of a (possibly scheduled) block onto k        *
+ * physical registers, as well as all necessary includes   *
+ * and using statements not already present in             *
+ * scheduler.h.                                            *
+ *                                                         *
+ * Written by: Austin James Lee                            *
+ *                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+
+#include "scheduler.h"
+#include <climits>	// INT_MAX
+
+#define SPILL_BASE 32768	// first memory address used for spills
+#define NO_USE INT_MAX		// next use of a value never read again
+
+
+//// Allocator class ////
+
+class Allocator {
+	public:
+		// constructor. allocates the schedule in s (or, if s was
+		// not scheduled, its Nodes in order) to k registers.
+		// physical and nextUse are indexed like Scheduler::vr.
+		// registers read before the block defines them keep
+		// their numbers, so each must be below k.
+		Allocator(Scheduler& s, int k, const Machine& m);
+		void print(ostream& os) const;	// prints allocated ILOC
+		string error;				// why s could not be allocated, or empty
+		vector<Instruction> code;	// width slots per cycle, naming prs
+		vector<int> physical;		// pr of each operand of each Node
+		vector<int> nextUse;		// bundle reading each operand next
+		int width;					// slots per cycle in code
+		bool bundled;				// print cycles as [ op ; op ]
+	private:
+		Scheduler& s;			// block being allocated
+		int k;					// number of physical registers
+		const Machine& m;		// units spill code may issue on
+		int reserved;			// pr holding spill addresses, or INVALID
+		int nextSpill;			// next free spill address
+		int b;					// index of bundle being allocated
+		vector<int> order;		// Node in each slot, width per bundle
+		vector<int> vrToPr;		// pr holding each VR, or INVALID
+		vector<int> prToVr;		// VR held by each pr, or INVALID
+		vector<int> prNext;		// next use of value in each pr
+		vector<int> prFreeAt;	// bundle a dead def's write has landed by
+		vector<bool> pinned;	// prs the current bundle must keep
+		vector<int> spillAddr;	// where each VR was spilled, or INVALID
+		vector<int> rematValue;	// constant a VR was loadI'd from
+		vector<bool> remat;		// VR can be recomputed by loadI
+		vector<int> liveIn;		// register each VR arrives in, or INVALID
+		vector<int> firstUse;	// bundle first reading each VR
+		bool run(bool reserve);	// allocates; false if reserve needed
+		void computeNextUses();	// sets nu of every operand, and liveIn
+		bool getPR(int& pr);	// frees a pr, spilling if necessary
+		bool clean(int pr) const;	// value in pr needs no store
+		bool spill(int pr);		// evicts value held in pr
+		bool restore(int vr, int pr);	// brings vr back into pr
+		void emit(const Instruction& i);	// adds a one-op cycle
+		void assign(int vr, int pr, int nu);	// records vr in pr
+		Instruction copy(int n) const;	// Node n naming its prs
+};
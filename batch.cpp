@@ -0,0 +1,168 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                       *
+ * batch.cpp                                             *
+ *                                                       *
+ * Contains implementations for everything in batch.h.   *
+ * Methods appear in same order as they do in batch.h.   *
+ *                                                       *
+ * Written by: Austin James Lee                          *
+ *                                                       *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "batch.h"
+
+
+//// public Batch methods ////
+
+
+// constructor.
+// expands directories into the ILOC files below them and
+// sorts the result, so the work list (and therefore every
+// output) is the same no matter how many threads run.
+Batch::Batch(const vector<string>& paths, string out, int t, const Options& o)
+		:outdir{out}, threads{t}, opts(o) {
+	for (auto& p : paths)
+		collect(p, "");
+	sort(inputs.begin(), inputs.end());
+	if (threads < 1)
+		threads = 1;
+}
+
+
+// schedules every input on a pool of worker threads.
+// each worker claims the next unclaimed file and writes
+// its result to that file's own output, so no output is
+// shared between threads. the result goes to a temporary
+// file beside its output, renamed over it only once the
+// file has scheduled, so no output is left half written.
+// a file that is missing or has errors in it is reported
+// on stderr, counted as a failure and left with no
+// output; the rest go on. returns number of failures.
+int Batch::run() {
+	// inputs at the same path below two named
+	// directories would share an output
+	vector<string> outputs;
+	for (auto& in : inputs)
+		outputs.push_back(outputFor(in.second));
+	sort(outputs.begin(), outputs.end());
+	auto dup = adjacent_find(outputs.begin(), outputs.end());
+	if (dup != outputs.end()) {
+		cerr << "error: more than one input would write " << *dup << endl;
+		return inputs.size();
+	}
+
+	atomic<size_t> next {0};
+	atomic<int> failed {0};
+	auto start = std::chrono::steady_clock::now();
+
+	auto work = [&]() {
+		size_t i;
+		while ((i = next++) < inputs.size()) {
+			const string& in = inputs[i].first;
+			string output = outputFor(inputs[i].second);
+			string temp = output + ".tmp";
+			// as sched does for a single file, but go on
+			struct stat st;
+			if (stat(in.c_str(), &st) != 0 || S_ISDIR(st.st_mode)) {
+				cerr << "error: invalid filename: " + in + "\n";
+				remove(output.c_str());
+				++failed;
+				continue;
+			}
+			ofstream out;
+			if (makeParents(output))
+				out.open(temp);
+			if (!out) {
+				cerr << "error: cannot write " + output + "\n";
+				++failed;
+				continue;
+			}
+			bool ok = runScheduler(in, opts, out);
+			out.close();
+			if (ok && out && rename(temp.c_str(), output.c_str()) == 0)
+				continue;
+			if (ok)
+				cerr << "error: cannot write " + output + "\n";
+			remove(temp.c_str());
+			remove(output.c_str());
+			++failed;
+		}
+	};
+
+	vector<thread> pool;
+	for (int t = 0; t < threads; ++t)
+		pool.push_back(thread {work});
+	for (auto& t : pool)
+		t.join();
+
+	double secs = std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start).count();
+	cerr << "batch: " << inputs.size() << " files, " << failed << " failed, "
+		<< threads << " threads, " << secs << " s, "
+		<< (secs > 0 ? inputs.size() / secs : 0) << " files/s" << endl;
+
+	return failed;
+}
+
+
+//// private Batch methods ////
+
+
+// adds path to inputs if it is a file, or every
+// file ending in ".i" below it if it is a directory.
+// below is the path from the named directory down to
+// path, or empty if path was named. a named path may be
+// a link to a directory, but links to directories found
+// below are skipped, so a link to a parent cannot loop.
+void Batch::collect(const string& path, const string& below) {
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+		inputs.push_back({path, path.substr(path.find_last_of('/') + 1)});
+		return;
+	}
+
+	DIR* dir = opendir(path.c_str());
+	if (!dir)
+		return;
+	while (struct dirent* e = readdir(dir)) {
+		string name = e->d_name;
+		if (name == "." || name == "..")
+			continue;
+		string full = path + "/" + name;
+		bool isDir = lstat(full.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+		bool linksToDir = !isDir && stat(full.c_str(), &st) == 0
+			&& S_ISDIR(st.st_mode);
+		if (isDir)
+			collect(full, below + name + "/");
+		else if (!linksToDir && name.size() > 2
+		&& name.compare(name.size() - 2, 2, ".i") == 0)
+			inputs.push_back({full, below + name});
+	}
+	closedir(dir);
+}
+
+
+// result file for an input at path below under a named
+// directory (or named itself): the same path inside
+// outdir, with ".i" replaced by ".out".
+string Batch::outputFor(const string& below) const {
+	string name = below;
+	if (name.size() > 2 && name.compare(name.size() - 2, 2, ".i") == 0)
+		name.erase(name.size() - 2);
+	return outdir + "/" + name + ".out";
+}
+
+
+// creates each missing directory between outdir
+// and file. returns false if one cannot be made.
+bool Batch::makeParents(const string& file) const {
+	for (size_t slash = outdir.size() + 1;
+			(slash = file.find('/', slash)) != string::npos; ++slash) {
+		string dir = file.substr(0, slash);
+		struct stat st;
+		if (stat(dir.c_str(), &st) != 0 && mkdir(dir.c_str(), 0755) != 0
+		&& errno != EEXIST)
+			return false;
+	}
+	return true;
+}
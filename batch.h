@@ -0,0 +1,49 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                         *
+ * batch.h                                                 *
+ *                                                         *
+ * Contains declaration for Batch class, which schedules   *
+ * many ILOC files in one process on a pool of worker      *
+ * threads, as well as all necessary includes and using    *
+ * statements not already present in scheduler.h.          *
+ *                                                         *
+ * Written by: Austin James Lee                            *
+ *                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+
+#include "scheduler.h"
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <dirent.h>	// opendir(), readdir(), closedir()
+#include <cstdio>	// rename(), remove()
+#include <cerrno>	// errno, EEXIST
+
+using std::thread;
+using std::atomic;
+using std::adjacent_find;
+
+
+//// Batch class ////
+
+class Batch {
+	public:
+		// constructor. takes files and/or directories to schedule,
+		// directory for results (which must exist), and number of
+		// worker threads.
+		Batch(const vector<string>& paths, string out, int t, const Options& o);
+		int run();				// schedules every input, returns failures
+		// ILOC files found under paths, each with its path below
+		// the one named (just its name, if it was named), sorted
+		vector<pair<string, string>> inputs;
+	private:
+		string outdir;			// directory results are written to
+		int threads;			// number of worker threads
+		Options opts;			// options applied to every file
+		// adds path, or files below it named below + their name
+		void collect(const string& path, const string& below);
+		string outputFor(const string& below) const; // result file for input
+		bool makeParents(const string& file) const;	// creates dirs above file
+};
@@ -0,0 +1,182 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                         *
+ * bench.cpp                                               *
+ *                                                         *
+ * Main for the benchmark harness. Generates synthetic     *
+ * ILOC blocks of increasing length, runs each through     *
+ * the Scheduler pipeline, and reports the time spent in   *
+ * every phase, per-phase throughput, and peak memory as   *
+ * one JSON object per block on stdout.                    *
+ *                                                         *
+ * Run with [-h --help] option for additional info.        *
+ *                                                         *
+ * Written by: Austin James Lee                            *
+ *                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "generator.h"
+#include "scheduler.h"
+#include <cstring>		// strcmp()
+#include <sstream>		// istringstream
+#include <sys/resource.h>	// getrusage()
+#include <sys/wait.h>	// waitpid()
+
+using std::strcmp;
+using std::istringstream;
+
+// helper function prototypes
+void benchBlock(const GenParams& p, int threads);
+
+
+/// main ///
+int main(int argc, char* argv[]) {
+	vector<int> lengths {1000, 10000, 100000, 1000000};
+	vector<int> graphThreads {1};	// -t: threads building the graph
+	GenParams params;
+	bool generate = false;		// -g: write one block to stdout
+	string usage = "usage: schedbench [-h] [-g] [-n <ops>[,<ops>...]] [-r <regs>]\n"
+					"                  [-m <fraction>] [-d <depth>] [-x <seed>]\n"
+					"                  [-t <threads>[,<threads>...]]";
+	string help = "\n"
+		"\'schedbench\' generates synthetic ILOC blocks and times every phase of\n"
+		"the scheduler on them. each block is run in its own process and\n"
+		"reported as one line of JSON holding per-phase seconds, per-phase\n"
+		"throughput in operations per second, and peak resident memory.\n\n"
+		+ usage + "\n\n"
+		"Program arguments:\n"
+		"      -h   prints this help summary and exits.\n"
+		"      -g   writes a single generated block (the first -n length)\n"
+		"           to stdout instead of benchmarking.\n"
+		"      -n   comma separated block lengths (default 1000,10000,\n"
+		"           100000,1000000).\n"
+		"      -r   registers available to the generator (default 16).\n"
+		"      -m   fraction of operations that touch memory (default 0.01).\n"
+		"      -d   dependency depth: sources are drawn from the last <depth>\n"
+		"           values defined (default 8).\n"
+		"      -x   random seed (default 1).\n"
+		"      -t   comma separated numbers of threads to build the\n"
+		"           dependency graph on; each block is run once per\n"
+		"           number (default 1).\n";
+
+	for (int a = 1; a < argc; ++a) {
+		bool hasValue = a + 1 < argc;
+		if (strcmp(argv[a], "-h") == 0 || strcmp(argv[a], "--help") == 0) {
+			cout << help << endl;
+			return 0;
+		} else if (strcmp(argv[a], "-g") == 0)
+			generate = true;
+		else if (strcmp(argv[a], "-n") == 0 && hasValue) {
+			lengths.clear();
+			istringstream list (argv[++a]);
+			string len;
+			while (getline(list, len, ','))
+				lengths.push_back(atoi(len.c_str()));
+		} else if (strcmp(argv[a], "-r") == 0 && hasValue)
+			params.registers = atoi(argv[++a]);
+		else if (strcmp(argv[a], "-m") == 0 && hasValue)
+			params.memory = atof(argv[++a]);
+		else if (strcmp(argv[a], "-d") == 0 && hasValue)
+			params.depth = atoi(argv[++a]);
+		else if (strcmp(argv[a], "-x") == 0 && hasValue)
+			params.seed = atoi(argv[++a]);
+		else if (strcmp(argv[a], "-t") == 0 && hasValue) {
+			graphThreads.clear();
+			istringstream list (argv[++a]);
+			string threads;
+			while (getline(list, threads, ','))
+				graphThreads.push_back(atoi(threads.c_str()));
+		}
+		else {
+			cerr << "error: invalid argument: "
+				<< argv[a] << endl << usage << endl;
+			return 1;
+		}
+	}
+
+	if (lengths.empty() || params.registers < 2 || params.depth < 1 ||
+			graphThreads.empty() ||
+			*std::min_element(graphThreads.begin(), graphThreads.end()) < 1) {
+		cerr << "error: invalid generator parameters" << endl << usage << endl;
+		return 1;
+	}
+
+	if (generate) {
+		params.length = lengths[0];
+		generateBlock(cout, params);
+		return 0;
+	}
+
+	// one process per run, so peak memory is that run's alone
+	for (int len : lengths)
+		for (int threads : graphThreads) {
+			params.length = len;
+			cout.flush();
+			pid_t pid = fork();
+			if (pid == 0) {
+				benchBlock(params, threads);
+				exit(0);
+			}
+			int status;
+			waitpid(pid, &status, 0);
+			if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+				cerr << "error: benchmark of " << len << " ops failed" << endl;
+				return 1;
+			}
+		}
+
+	return 0;
+}
+
+
+// generates the block described by p into a temporary
+// file, runs it through every phase (building the graph
+// on threads threads), and prints the result as one line
+// of JSON.
+void benchBlock(const GenParams& p, int threads) {
+	char path[] = "/tmp/schedbench-XXXXXX";
+	int fd = mkstemp(path);
+	if (fd < 0) {
+		cerr << "error: cannot create temporary file" << endl;
+		exit(1);
+	}
+	close(fd);
+	{
+		ofstream block (path);
+		generateBlock(block, p);
+	}
+
+	Options opts;
+	opts.graphThreads = threads;
+	Scheduler s {path, false, opts};
+	s.listSchedule(Machine {});
+	ofstream sink ("/dev/null");
+	Clock::time_point start = Clock::now();
+	sink << s;
+	s.lap(PrintPhase, start);
+
+	struct stat st;
+	stat(path, &st);
+	unlink(path);
+	struct rusage ru;
+	getrusage(RUSAGE_SELF, &ru);
+
+	cout << "{\"ops\":" << p.length
+		<< ",\"registers\":" << p.registers
+		<< ",\"memory\":" << p.memory
+		<< ",\"depth\":" << p.depth
+		<< ",\"seed\":" << p.seed
+		<< ",\"graphThreads\":" << threads
+		<< ",\"bytes\":" << st.st_size
+		<< ",\"nodes\":" << s.nodes.size()
+		<< ",\"edges\":" << s.children.size()
+		<< ",\"cycles\":" << s.slots.size() / s.width
+		<< ",\"peak_rss_kb\":" << ru.ru_maxrss
+		<< ",\"phases\":{";
+	for (int ph = 0; ph < NumPhases; ++ph) {
+		double secs = s.seconds[ph];
+		cout << (ph ? "," : "") << "\"" << phaseNames[ph] << "\":{\"seconds\":"
+			<< secs << ",\"ops_per_sec\":"
+			<< (secs > 0 ? s.nodes.size() / secs : 0) << "}";
+	}
+	cout << "}}" << endl;
+}
@@ -0,0 +1,22 @@
+//SIM INPUT: -i 1024 10 20
+//OUTPUT: 30 20 0
+
+// r1 and r2 are read before the block defines them, so
+// once allocated they must still be read from r1 and r2
+// (which hold 0 on entry), not from whichever register
+// is free at the time and holds some dead value.
+loadI   1024   => r3
+load    r3     => r4
+loadI   1028   => r5
+load    r5     => r6
+add     r4, r6 => r7
+add     r7, r1 => r7
+store   r7     => r3
+output  1024
+mult    r4, r2 => r4
+add     r4, r6 => r4
+store   r4     => r5
+output  1028
+add     r1, r2 => r6
+store   r6     => r3
+output  1024
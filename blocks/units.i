@@ -0,0 +1,21 @@
+//SIM INPUT: -i 1024 10 20
+//OUTPUT: 126
+
+// A load and an add are ready together in cycle 2. The add
+// may issue on either unit but the load only on unit 0, so
+// the add must leave unit 0 to the load.
+loadI   1024 => r1
+loadI   3    => r7
+load    r1   => r2
+add     r7, r7 => r6
+add     r6, r6 => r5
+add     r5, r5 => r4
+add     r4, r4 => r3
+add     r3, r3 => r8
+add     r8, r2 => r9
+loadI   1028 => r10
+load    r10  => r11
+add     r9, r11 => r12
+loadI   2048 => r13
+store   r12  => r13
+output  2048
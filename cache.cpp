@@ -0,0 +1,187 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                         *
+ * cache.cpp                                               *
+ *                                                         *
+ * Contains implementations for everything in cache.h and  *
+ * for Scheduler::loadIR and Scheduler::saveIR.            *
+ *                                                         *
+ * A cache file holds the renamed IR exactly as it sits in *
+ * memory, so loading it is one mapping and two copies.    *
+ * A cache is trusted only if its header matches the       *
+ * running program and the source's size and contents'     *
+ * hash. Modification times are not trusted: they can be   *
+ * preserved or reset while the contents change.           *
+ *                                                         *
+ * Written by: Austin James Lee                            *
+ *                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "cache.h"
+
+
+// returns the 64 bit FNV-1a hash of n bytes at p
+uint64_t fnv1a(const char* p, size_t n, uint64_t h) {
+	for (size_t i = 0; i < n; ++i)
+		h = (h ^ (unsigned char)p[i]) * FNV_PRIME;
+	return h;
+}
+
+
+// returns FNV-1a taken over n bytes at p 8 bytes at a
+// time (the last n % 8 a byte at a time). chaining calls
+// through h gives the same result as one call as long as
+// every piece but the last is a multiple of 8 bytes.
+uint64_t checksum(const char* p, size_t n, uint64_t h) {
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		uint64_t w;
+		memcpy(&w, p + i, 8);
+		h = (h ^ w) * FNV_PRIME;
+	}
+	return fnv1a(p + i, n - i, h);
+}
+
+
+// returns the absolute path of infile, or infile if it
+// cannot be resolved
+static string absolutePath(const string& infile) {
+	char* full = realpath(infile.c_str(), nullptr);
+	if (!full)
+		return infile;
+	string path = full;
+	free(full);
+	return path;
+}
+
+
+// returns the cache file for infile: next to it when dir
+// is empty, otherwise in dir, named after the source and
+// a hash of its absolute path so equal names do not collide
+string cachePath(const string& infile, const string& dir) {
+	if (dir.empty())
+		return infile + CACHE_SUFFIX;
+
+	string full = absolutePath(infile);
+	static const char digits[] = "0123456789abcdef";
+	uint64_t h = fnv1a(full.data(), full.size());
+	string hex;
+	for (int shift = 60; shift >= 0; shift -= 4)
+		hex += digits[h >> shift & 15];
+	return dir + "/" + full.substr(full.rfind('/') + 1)
+		+ "." + hex + CACHE_SUFFIX;
+}
+
+
+// sets size and hash to the length and checksum of
+// infile. returns false if it cannot be read.
+bool hashSource(const string& infile, uint64_t& size, uint64_t& hash) {
+	int fd = open(infile.c_str(), O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+		if (fd >= 0)
+			close(fd);
+		return false;
+	}
+	size = st.st_size;
+	hash = checksum(nullptr, 0);
+	if (size) {
+		void* m = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (m == MAP_FAILED) {
+			close(fd);
+			return false;
+		}
+		hash = checksum(static_cast<const char*>(m), size);
+		munmap(m, size);
+	}
+	close(fd);
+	return true;
+}
+
+
+// loads nodes and VRs from the cache file at path, if
+// it was made from a source of this size and hash.
+// returns false, changing nothing, if the cache is
+// missing, malformed, or made from other contents.
+bool Scheduler::loadIR(const string& path, uint64_t size, uint64_t hash) {
+	int fd = open(path.c_str(), O_RDONLY);
+	struct stat cs;
+	if (fd < 0 || fstat(fd, &cs) != 0
+			|| (size_t)cs.st_size < sizeof(CacheHeader)) {
+		if (fd >= 0)
+			close(fd);
+		return false;
+	}
+	void* m = mmap(nullptr, cs.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (m == MAP_FAILED)
+		return false;
+
+	const CacheHeader& h = *static_cast<const CacheHeader*>(m);
+	const char* body = static_cast<const char*>(m) + sizeof(CacheHeader);
+	bool valid = memcmp(h.magic, CACHE_MAGIC, sizeof h.magic) == 0
+		&& h.version == CACHE_VERSION
+		&& h.record == sizeof(Instruction)
+		&& h.sourceSize == size
+		&& h.sourceHash == hash
+		&& (uint64_t)cs.st_size == sizeof(CacheHeader) + h.nodes
+			* (sizeof(Instruction) + NumOperands * sizeof(int))
+		&& h.bodyHash == checksum(body, cs.st_size - sizeof(CacheHeader),
+			checksum((const char*)&h.instructions, CACHE_COUNTERS));
+
+	if (valid) {
+		const Instruction* in = reinterpret_cast<const Instruction*>(body);
+		const int* v = reinterpret_cast<const int*>(in + h.nodes);
+		nodes.assign(in, in + h.nodes);
+		vr.assign(v, v + NumOperands * h.nodes);
+		instructions = h.instructions;
+		tokens = h.tokens;
+		numVRs = h.numVRs;
+	}
+	munmap(m, cs.st_size);
+	return valid;
+}
+
+
+// writes nodes and VRs to the cache file at path,
+// recording the size and hash of the buffer the Parser
+// read them from (not a second read of the source), so
+// the cache is keyed by the contents it was made from
+// even if the file changed after loadIR checked it. the
+// file is written under a temporary name and renamed
+// into place, so readers (including other batch
+// workers) never see a partial cache. failure to write
+// a cache is not an error; the next run simply parses.
+void Scheduler::saveIR(const string& path, uint64_t size, uint64_t hash) const {
+	CacheHeader h {};
+	memcpy(h.magic, CACHE_MAGIC, sizeof h.magic);
+	h.version = CACHE_VERSION;
+	h.record = sizeof(Instruction);
+	h.sourceSize = size;
+	h.sourceHash = hash;
+	h.instructions = instructions;
+	h.tokens = tokens;
+	h.nodes = nodes.size();
+	h.numVRs = numVRs;
+	// nodes are 16 bytes each, so hashing them and
+	// then the VRs matches hashing the body in one piece
+	const char* in = reinterpret_cast<const char*>(nodes.data());
+	const char* v = reinterpret_cast<const char*>(vr.data());
+	size_t inBytes = nodes.size() * sizeof(Instruction);
+	size_t vBytes = vr.size() * sizeof(int);
+	h.bodyHash = checksum(v, vBytes, checksum(in, inBytes,
+		checksum((const char*)&h.instructions, CACHE_COUNTERS)));
+
+	string tmp = path + ".XXXXXX";
+	int fd = mkstemp(&tmp[0]);
+	if (fd < 0)
+		return;
+	fchmod(fd, 0644);
+	ofstream out (tmp, std::ios::binary);
+	close(fd);
+	out.write(reinterpret_cast<const char*>(&h), sizeof h);
+	out.write(in, inBytes);
+	out.write(v, vBytes);
+	out.close();
+	if (!out || std::rename(tmp.c_str(), path.c_str()) != 0)
+		std::remove(tmp.c_str());
+}
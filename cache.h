@@ -0,0 +1,64 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                         *
+ * cache.h                                                 *
+ *                                                         *
+ * Contains declarations for the binary IR cache: the      *
+ * CacheHeader structure that begins every cache file and  *
+ * helpers that name and validate cache files, as well as  *
+ * all necessary includes not already present in           *
+ * scheduler.h. Scheduler::loadIR and Scheduler::saveIR    *
+ * are implemented in cache.cpp.                           *
+ *                                                         *
+ * Written by: Austin James Lee                            *
+ *                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+
+#include "scheduler.h"
+#include <cstdio>	// rename(), remove()
+
+#define CACHE_MAGIC "SCHEDIR"	// first 8 bytes of every cache file
+#define CACHE_VERSION 1			// bump when the layout or IR changes
+#define CACHE_SUFFIX ".irc"		// appended to cache file names
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+#define CACHE_COUNTERS (4 * sizeof(uint64_t))	// instructions to numVRs
+
+
+//// CacheHeader structure ////
+
+// begins a cache file. it is followed by nodes Instructions
+// and then NumOperands * nodes VRs. a cache is used only when
+// the source's size and the hash of its contents match.
+struct CacheHeader {
+	char magic[8];			// CACHE_MAGIC
+	uint32_t version;		// CACHE_VERSION
+	uint32_t record;		// sizeof(Instruction)
+	uint64_t sourceSize;	// bytes in the source
+	uint64_t sourceHash;	// checksum of the source's contents
+	uint64_t instructions;	// Scheduler counters restored from cache
+	uint64_t tokens;
+	uint64_t nodes;
+	uint64_t numVRs;
+	uint64_t bodyHash;		// checksum of the counters, then the body
+};
+
+
+// returns the 64 bit FNV-1a hash of n bytes at p
+uint64_t fnv1a(const char* p, size_t n, uint64_t h = FNV_OFFSET);
+
+// returns FNV-1a taken over n bytes at p 8 bytes at a
+// time (the last n % 8 a byte at a time). used for cache
+// bodies, which are too large to hash a byte at a time.
+uint64_t checksum(const char* p, size_t n, uint64_t h = FNV_OFFSET);
+
+// sets size and hash to the length and checksum of
+// infile, to check a cache against before parsing.
+// returns false if it cannot be read.
+bool hashSource(const string& infile, uint64_t& size, uint64_t& hash);
+
+// returns the cache file for infile: next to it when dir
+// is empty, otherwise in dir, named after the source and
+// a hash of its absolute path so equal names do not collide
+string cachePath(const string& infile, const string& dir);
@@ -0,0 +1,146 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                         *
+ * client.cpp                                              *
+ *                                                         *
+ * Main for the test client of sched --serve. Sends files  *
+ * to a server listening on a Unix domain socket, prints   *
+ * its reports, and reports requests per second.           *
+ *                                                         *
+ * Run with [-h --help] option for additional info.        *
+ *                                                         *
+ * Written by: Austin James Lee                            *
+ *                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>	// stringstream
+#include <string>
+#include <vector>
+#include <chrono>	// steady_clock
+#include <cstdio>	// FILE, fdopen(), fwrite(), fread(), fgets()
+#include <cstdlib>	// atoi(), atol()
+#include <cstring>	// strcmp(), strcpy()
+#include <unistd.h>	// dup(), close()
+#include <sys/socket.h>	// socket(), connect()
+#include <sys/un.h>		// sockaddr_un
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::string;
+using std::vector;
+using std::ifstream;
+using std::stringstream;
+using std::strcmp;
+
+
+/// main ///
+int main(int argc, char* argv[]) {
+	int times = 1;			// -n: requests per file
+	bool paths = false;		// -p: send paths instead of ILOC
+	bool quiet = false;		// -q: do not print reports
+	vector<string> args;
+	string usage = "usage: schedclient [-h] [-n <times>] [-p] [-q] <socket> <file>...";
+	string help = "\n"
+		"\'schedclient\' sends each file to a server started with\n"
+		"\'sched --serve=<socket>\' over one connection, prints each report,\n"
+		"and reports requests per second on stderr.\n\n"
+		+ usage + "\n\n"
+		"Program arguments:\n"
+		"      -h   prints this help summary and exits.\n"
+		"      -n   sends every file this many times (default 1).\n"
+		"      -p   sends each file's path (\"file <path>\") instead of its\n"
+		"           ILOC (\"iloc <length>\").\n"
+		"      -q   prints only the summary.\n";
+
+	for (int a = 1; a < argc; ++a) {
+		if (strcmp(argv[a], "-h") == 0 || strcmp(argv[a], "--help") == 0) {
+			cout << help << endl;
+			return 0;
+		} else if (strcmp(argv[a], "-n") == 0 && a + 1 < argc)
+			times = atoi(argv[++a]);
+		else if (strcmp(argv[a], "-p") == 0)
+			paths = true;
+		else if (strcmp(argv[a], "-q") == 0)
+			quiet = true;
+		else if (argv[a][0] != '-')
+			args.push_back(argv[a]);
+		else {
+			cerr << "error: invalid argument: "
+				<< argv[a] << endl << usage << endl;
+			return 1;
+		}
+	}
+	if (args.size() < 2 || times < 1) {
+		cerr << "error: not enough arguments" << endl << usage << endl;
+		return 1;
+	}
+
+	// read every file first, so only the server is timed
+	vector<string> requests;
+	for (size_t f = 1; f < args.size(); ++f) {
+		if (paths) {
+			requests.push_back("file " + args[f] + "\n");
+			continue;
+		}
+		ifstream in (args[f]);
+		if (!in) {
+			cerr << "error: cannot read " << args[f] << endl;
+			return 1;
+		}
+		stringstream text;
+		text << in.rdbuf();
+		requests.push_back("iloc " + std::to_string(text.str().size()) + "\n"
+			+ text.str());
+	}
+
+	struct sockaddr_un addr {};
+	addr.sun_family = AF_UNIX;
+	if (args[0].size() >= sizeof addr.sun_path) {
+		cerr << "error: socket path too long: " << args[0] << endl;
+		return 1;
+	}
+	strcpy(addr.sun_path, args[0].c_str());
+	int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock < 0 || connect(sock, (struct sockaddr*)&addr, sizeof addr) != 0) {
+		cerr << "error: cannot connect to " << args[0] << endl;
+		return 1;
+	}
+	FILE* in = fdopen(sock, "r");
+	FILE* out = fdopen(dup(sock), "w");
+
+	long sent = 0, failed = 0;
+	string report;
+	char status[64];
+	auto start = std::chrono::steady_clock::now();
+	for (int t = 0; t < times; ++t)
+		for (const string& r : requests) {
+			fwrite(r.data(), 1, r.size(), out);
+			fflush(out);
+			if (!fgets(status, sizeof status, in)) {
+				cerr << "error: server closed the connection" << endl;
+				return 1;
+			}
+			const char* space = strchr(status, ' ');
+			report.resize(space ? atol(space + 1) : 0);
+			if (fread(&report[0], 1, report.size(), in) != report.size()) {
+				cerr << "error: short response" << endl;
+				return 1;
+			}
+			++sent;
+			if (strncmp(status, "ok ", 3) != 0)
+				++failed;
+			if (!quiet)
+				cout << report;
+		}
+	double secs = std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start).count();
+
+	fclose(out);
+	fclose(in);
+	cerr << "client: " << sent << " requests, " << failed << " failed, "
+		<< secs << " s, " << (secs > 0 ? sent / secs : 0) << " requests/s"
+		<< endl;
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,188 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                         *
+ * emitter.cpp                                             *
+ *                                                         *
+ * Contains implementations for everything in emitter.h.   *
+ * Methods appear in the same order as they do in          *
+ * emitter.h, with the private put() last.                 *
+ *                                                         *
+ * Written by: Austin James Lee                            *
+ *                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "emitter.h"
+
+
+//// public Emitter methods ////
+
+
+// constructor
+Emitter::Emitter(ostream& o) :os(o), used{0} {}
+
+
+// deconstructor
+// writes anything still buffered.
+Emitter::~Emitter() {
+	flush();
+}
+
+
+// appends a character
+void Emitter::put(char c) {
+	if (used == EMIT_BUFFER)
+		flush();
+	buf[used++] = c;
+}
+
+
+// appends a C string
+void Emitter::put(const char* s) {
+	put(s, strlen(s));
+}
+
+
+// appends a string
+void Emitter::put(const string& s) {
+	put(s.data(), s.size());
+}
+
+
+// appends v in decimal, followed by enough spaces to
+// fill width characters (like setw(width) << left).
+void Emitter::num(long v, int width) {
+	char digits[24];
+	int n = sizeof digits;
+	bool negative = v < 0;
+	unsigned long u = negative ? 0ul - v : v;
+	do {
+		digits[--n] = '0' + u % 10;
+		u /= 10;
+	} while (u);
+	if (negative)
+		digits[--n] = '-';
+	int len = sizeof digits - n;
+	put(digits + n, len);
+	spaces(width - len);
+}
+
+
+// appends n spaces (none if n <= 0)
+void Emitter::spaces(int n) {
+	while (n-- > 0)
+		put(' ');
+}
+
+
+// appends Instruction in the same layout as
+// operator<<(ostream&, const Instruction&).
+void Emitter::instruction(const Instruction& i, const int* names) {
+	const int* reg = names ? names : i.operand;
+	const char* name = i.op >= load && i.op <= nop
+		? opcodeNames[i.op] : "no es bueno";
+	int len = strlen(name);
+
+	// opcode, left justified in 7 columns
+	put(' ');
+	put(name, len);
+	switch (i.op) {
+		case loadI:
+			spaces(6 - len);
+			put(' ');
+			num(i.operand[Src1], 5);
+			break;
+		case output:
+			spaces(6 - len);
+			put(' ');
+			num(i.operand[Src1]);
+			put('\n');
+			return;
+		case nop:
+			spaces(7 - len);
+			put('\n');
+			return;
+		default:
+			spaces(7 - len);
+			break;
+	}
+
+	// src1
+	if (i.isReg(Src1)) {
+		put('r');
+		num(reg[Src1], 4);
+	}
+
+	// src2
+	if (i.isReg(Src2) && i.op != store) {
+		put(", r", 3);
+		num(reg[Src2], 4);
+	} else
+		spaces(7);
+
+	// arrow and dest
+	put("=> r", 4);
+	num(i.op == store ? reg[Src2] : reg[Dest]);
+	put('\n');
+}
+
+
+// appends Instruction as a valid ILOC operation
+// (no padding, no newline), naming registers by
+// names, or as written if names is null.
+void Emitter::iloc(const Instruction& i, const int* names) {
+	const int* reg = names ? names : i.operand;
+	put(opcodeNames[i.op]);
+	switch (i.op) {
+		case loadI:
+		case output:
+			put(' ');
+			num(i.operand[Src1]);
+			break;
+		case load:
+			put(" r", 2);
+			num(reg[Src1]);
+			break;
+		case store:
+			put(" r", 2);
+			num(reg[Src1]);
+			put(" => r", 5);
+			num(reg[Src2]);
+			return;
+		case nop:
+			return;
+		default:
+			put(" r", 2);
+			num(reg[Src1]);
+			put(", r", 3);
+			num(reg[Src2]);
+			break;
+	}
+	if (i.isReg(Dest)) {
+		put(" => r", 5);
+		num(reg[Dest]);
+	}
+}
+
+
+// writes buffer to stream
+void Emitter::flush() {
+	os.write(buf, used);
+	used = 0;
+}
+
+
+//// private Emitter methods ////
+
+
+// appends n bytes
+void Emitter::put(const char* s, size_t n) {
+	while (n > EMIT_BUFFER - used) {
+		size_t part = EMIT_BUFFER - used;
+		memcpy(buf + used, s, part);
+		used += part;
+		s += part;
+		n -= part;
+		flush();
+	}
+	memcpy(buf + used, s, n);
+	used += n;
+}
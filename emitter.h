@@ -0,0 +1,43 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                         *
+ * emitter.h                                               *
+ *                                                         *
+ * Contains declaration for Emitter class, a buffered      *
+ * writer that formats the scheduler's reports without     *
+ * iostream formatting or per-line flushes, as well as     *
+ * all necessary includes not already present in parser.h *
+ *                                                         *
+ * Written by: Austin James Lee                            *
+ *                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+
+#include "parser.h"
+#include <cstring>	// memcpy(), strlen()
+
+#define EMIT_BUFFER 65536	// bytes buffered before writing
+
+
+//// Emitter class ////
+
+class Emitter {
+	public:
+		Emitter(ostream& o);	// constructor, takes stream to write
+		~Emitter();				// deconstructor, flushes buffer
+		void put(char c);		// appends a character
+		void put(const char* s);	// appends a C string
+		void put(const string& s);	// appends a string
+		void num(long v, int width = 0);	// appends v, left justified
+		void spaces(int n);		// appends n spaces
+		// as operator<<, naming registers by names, which holds
+		// NumOperands entries (e.g. VRs), or as written if null
+		void instruction(const Instruction& i, const int* names = nullptr);
+		void iloc(const Instruction& i, const int* names = nullptr);	// as ILOC
+		void flush();			// writes buffer to stream
+	private:
+		ostream& os;			// stream being written
+		char buf[EMIT_BUFFER];	// pending output
+		size_t used;			// bytes of buf in use
+		void put(const char* s, size_t n);	// appends n bytes
+};
@@ -0,0 +1,85 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                         *
+ * generator.cpp                                           *
+ *                                                         *
+ * Contains implementations for everything in generator.h. *
+ *                                                         *
+ * Written by: Austin James Lee                            *
+ *                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "generator.h"
+
+
+// GenParams constructor
+GenParams::GenParams(int l, int r, double m, int d, unsigned s)
+		:length{l}, registers{r}, memory{m}, depth{d}, seed{s} {}
+
+
+// writes a synthetic ILOC block described by p to os.
+//
+// r0 holds a base address for the whole block. every other
+// operation either touches memory (a loadI of an address
+// followed by a load or store, or an output) or computes.
+// arithmetic sources are drawn from the last p.depth
+// values defined, so a small depth yields long dependence
+// chains and a large depth yields wide, shallow graphs.
+// destinations are drawn from r1 up to p.registers - 1.
+void generateBlock(ostream& os, const GenParams& p) {
+	mt19937 rng {p.seed};
+	uniform_real_distribution<double> roll (0.0, 1.0);
+	uniform_int_distribution<int> dest (1, p.registers > 1 ? p.registers - 1 : 1);
+	uniform_int_distribution<int> slot (0, 63);
+	uniform_int_distribution<int> arith (add, rshift);
+	vector<int> recent;		// registers of the last depth values
+	size_t oldest = 0;		// next entry of recent to replace
+
+	// returns a register holding a recent value
+	auto source = [&]() {
+		uniform_int_distribution<size_t> pick (0, recent.size() - 1);
+		return recent[pick(rng)];
+	};
+	// records r as holding the newest value
+	auto define = [&](int r) {
+		if ((int)recent.size() < p.depth)
+			recent.push_back(r);
+		else {
+			recent[oldest] = r;
+			oldest = (oldest + 1) % recent.size();
+		}
+	};
+
+	os << "// synthetic block: " << p.length << " ops, "
+		<< p.registers << " registers, memory " << p.memory
+		<< ", depth " << p.depth << ", seed " << p.seed << "\n";
+	os << "loadI 1024 => r0\n";
+
+	int n = 1;
+	while (n < p.length) {
+		double r = roll(rng);
+		int d = dest(rng);
+
+		if (recent.empty() || r < p.memory / 2) {
+			// value from memory
+			os << "loadI " << 1024 + 4 * slot(rng) << " => r" << d << "\n";
+			os << "load r" << d << " => r" << d << "\n";
+			define(d);
+			n += 2;
+		} else if (r < p.memory * 0.95) {
+			// value to memory
+			os << "loadI " << 1024 + 4 * slot(rng) << " => r" << d << "\n";
+			os << "store r" << source() << " => r" << d << "\n";
+			n += 2;
+		} else if (r < p.memory) {
+			os << "output " << 1024 + 4 * slot(rng) << "\n";
+			n += 1;
+		} else {
+			int s1 = source();
+			int s2 = source();
+			os << opcodeNames[arith(rng)] << " r" << s1 << ", r" << s2
+				<< " => r" << d << "\n";
+			define(d);
+			n += 1;
+		}
+	}
+}
@@ -0,0 +1,40 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                         *
+ * generator.h                                             *
+ *                                                         *
+ * Contains declarations for GenParams structure and the   *
+ * synthetic ILOC block generator used by the benchmark    *
+ * harness, as well as all necessary includes and using    *
+ * statements not already present in scanner.h.            *
+ *                                                         *
+ * Written by: Austin James Lee                            *
+ *                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+
+#include "scanner.h"
+#include <random>	// mt19937, uniform distributions
+#include <vector>
+
+using std::vector;
+using std::mt19937;
+using std::uniform_int_distribution;
+using std::uniform_real_distribution;
+
+
+//// GenParams structure ////
+
+struct GenParams {
+	// constructor. takes values in order they are declared
+	GenParams(int = 10000, int = 16, double = 0.01, int = 8, unsigned = 1);
+	int length;			// number of operations to generate
+	int registers;		// distinct registers (register pressure)
+	double memory;		// fraction of operations touching memory
+	int depth;			// operands come from the last depth values
+	unsigned seed;		// random seed; same seed, same block
+};
+
+
+// writes a synthetic ILOC block described by p to os.
+void generateBlock(ostream& os, const GenParams& p);
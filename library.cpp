@@ -0,0 +1,78 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                         *
+ * library.cpp                                             *
+ *                                                         *
+ * Contains implementations for everything in library.h.   *
+ *                                                         *
+ * The Scheduler's arrays are moved into the Result, so    *
+ * nothing is copied, written to a file, or formatted as   *
+ * text on the way back to the caller.                     *
+ *                                                         *
+ * Written by: Austin James Lee                            *
+ *                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "library.h"
+
+
+// returns the problems with opts as diagnostics under
+// name, in a Result holding nothing else.
+static Result rejectOptions(const vector<string>& problems,
+		const string& name) {
+	Result r;
+	for (const string& p : problems)
+		r.diagnostics.push_back(Diagnostic {name, 0, 0, "invalid options: " + p});
+	r.width = 0;
+	return r;
+}
+
+
+// schedules text[0, length) in place, unless opts are
+// unusable.
+Result scheduleILOC(const char* text, size_t length,
+		const Options& opts, const string& name) {
+	vector<string> problems = opts.problems();
+	if (!problems.empty())
+		return rejectOptions(problems, name);
+
+	Scheduler s {text, length, name, opts};
+	if (opts.schedule)
+		s.listSchedule(opts.machine, opts.heuristics);
+
+	Result r;
+	r.diagnostics = std::move(s.diagnostics);
+	r.nodes = std::move(s.nodes);
+	r.vr = std::move(s.vr);
+	r.weights = std::move(s.weights);
+	r.earliestStart = std::move(s.earliestStart);
+	r.latestStart = std::move(s.latestStart);
+	r.criticalPath = std::move(s.criticalPath);
+	r.childStart = std::move(s.childStart);
+	r.children = std::move(s.children);
+	r.parentStart = std::move(s.parentStart);
+	r.parents = std::move(s.parents);
+	r.issue = std::move(s.issue);
+	r.slots = std::move(s.slots);
+	r.width = s.width;
+	return r;
+}
+
+
+// schedules a string in place.
+Result scheduleILOC(const string& text, const Options& opts,
+		const string& name) {
+	return scheduleILOC(text.data(), text.size(), opts, name);
+}
+
+
+// reads in to its end, then schedules what was read.
+// unusable opts are reported without reading in.
+Result scheduleILOC(istream& in, const Options& opts, const string& name) {
+	vector<string> problems = opts.problems();
+	if (!problems.empty())
+		return rejectOptions(problems, name);
+
+	string text {std::istreambuf_iterator<char>(in),
+		std::istreambuf_iterator<char>()};
+	return scheduleILOC(text, opts, name);
+}
@@ -0,0 +1,62 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                         *
+ * library.h                                               *
+ *                                                         *
+ * Contains declarations for the in-process interface of   *
+ * libsched.a: the Result structure and scheduleILOC,      *
+ * which schedule ILOC already in memory or on a stream    *
+ * and hand back the graph and schedule as plain data, as  *
+ * well as all necessary includes not already present in   *
+ * scheduler.h.                                            *
+ *                                                         *
+ * Written by: Austin James Lee                            *
+ *                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+
+#include "scheduler.h"
+#include <iterator>	// istreambuf_iterator
+
+using std::istream;
+
+
+//// Result structure ////
+
+// everything scheduling a block produces, laid out as in
+// Scheduler: Nodes by label with NumOperands VRs each,
+// edges in compressed sparse row form, and (if scheduled)
+// width slots per cycle holding labels or INVALID (nop).
+struct Result {
+	vector<Diagnostic> diagnostics;	// errors in the ILOC (see Options)
+	vector<Instruction> nodes;	// operands as written
+	vector<int> vr;				// VR of each operand of each Node
+	vector<int> weights;		// latency-weighted distance to root
+	vector<int> earliestStart;	// with opts.slack: first cycle each Node
+	vector<int> latestStart;	// could issue in, last cycle, and a
+	vector<int> criticalPath;	// longest path, as in Scheduler
+	vector<int> childStart;
+	vector<int> children;
+	vector<int> parentStart;
+	vector<int> parents;
+	vector<int> issue;			// cycle each Node issues in, if scheduled
+	vector<int> slots;
+	int width;					// units per cycle, or 0 if not scheduled
+};
+
+
+// schedule the ILOC in text[0, length), a string, or
+// everything left on in, as sched would with opts (-s,
+// -f, -u, -p, -g, -d, -r, --slack and --recover; registers,
+// cache, simulate and stats are ignored). errors are
+// returned in diagnostics, under name; without
+// opts.recover the graph covers what came before the
+// first. if opts are out of range (see
+// Options::problems), diagnostics say why and nothing
+// is scheduled.
+Result scheduleILOC(const char* text, size_t length,
+	const Options& opts = Options(), const string& name = "<buffer>");
+Result scheduleILOC(const string& text, const Options& opts = Options(),
+	const string& name = "<buffer>");
+Result scheduleILOC(istream& in, const Options& opts = Options(),
+	const string& name = "<stream>");
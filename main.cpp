@@ -18,32 +18,131 @@
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 #define MIN_ARGS 2
-#define MAX_ARGS 2
 
-#include "scheduler.h"
-#include <cstring>	// strcmp()
+#include "batch.h"
+#include "window.h"
+#include "server.h"
+#include <cstring>	// strcmp(), strncmp(), strchr()
 
 using std::strcmp;
+using std::strncmp;
+using std::strchr;
 
 // helper function prototypes
 bool validFile(string filename);
+bool validDir(const string& dir);
+bool makeDir(const string& dir);
+bool parseUnits(const char* arg, int& op, unsigned& mask);
+bool parseHeuristics(const char* arg, vector<Heuristic>& list);
 
 
 /// main ///
 int main(int argc, char* argv[]) {
-	string infile = "";
-	string usage = "usage: reader [-h --help] <filename>\n"
+	vector<string> infiles;
+	Options opts;
+	int width = 2;				// -f: number of functional units
+	vector<pair<int, unsigned>> unitRules;	// -u: per-opcode units
+	bool batch = false;			// -b: schedule many files
+	string outdir = ".";		// -o: directory for batch results
+	int threads = thread::hardware_concurrency();	// -j: batch workers
+	int registers = 0;			// -k: physical registers
+	int window = 0;				// -w: stream through a window of n
+	bool serve = false;			// --serve: answer requests until killed
+	string socketPath;			// --serve=<socket>: on a socket, not stdin
+	string usage = "usage: sched [-h --help] [-s] [-f <n>] [-u <op>=<units>] [-p <h>,...] [-g <n>] [-k <n>] [-d] [-r] [--slack] [--sim] [--stats] [--recover] [--cache[=<dir>]] <filename>\n"
+					"       sched -b [-o <dir>] [-j <n>] [options] <file|dir>...\n"
+					"       sched -w <n> [-s] [-f <n>] [-u <op>=<units>] [--recover] <filename|->\n"
+					"       sched --serve[=<socket>] [-j <n>] [options]\n"
 					"where: <filename> is the name of the file to be compiled\n"
 					"       and brackets indicate program options.\n"
 					"**invoke the help option for further details.";
 	string help = "\n"
-		"\'sched\' performs the first half of instruction scheduling by constructing\n"
-		"a dependency graph from the ILOC code found in the input file and then\n"
-		"calculating the latency-weighted distances between each node and a root node.\n\n"
-		"usage: reader [-h --help] <filename>\n\n"
+		"\'sched\' performs instruction scheduling by constructing a dependency\n"
+		"graph from the ILOC code found in the input file, calculating the\n"
+		"latency-weighted distances between each node and a root node, and\n"
+		"(with -s) list scheduling the block onto the target machine.\n\n"
+		"usage: sched [-h --help] [-s] [-f <n>] [-u <op>=<units>] [-p <h>,...] [-g <n>] [-k <n>] [-d] [-r] [--slack] [--sim] [--stats] [--recover] [--cache[=<dir>]] <filename>\n"
+		"       sched -b [-o <dir>] [-j <n>] [options] <file|dir>...\n"
+		"       sched -w <n> [-s] [-f <n>] [-u <op>=<units>] [--recover] <filename|->\n"
+		"       sched --serve[=<socket>] [-j <n>] [options]\n\n"
 		"Program arguments:\n"
 		"      -h   help option. prints this help summary and exits the simulation.\n"
 		"           --help is the verbose form of this option.\n"
+		"      -s   prints the scheduled ILOC, one cycle per line as\n"
+		"           [ op1 ; op2 ], instead of the dependency graph.\n"
+		"  -f <n>   number of functional units (1 to 16, default 2).\n"
+		"           with two or more, load and store issue only on unit 0\n"
+		"           and mult only on unit 1.\n"
+		"-u <op>=<units>\n"
+		"           restricts opcode <op> to the comma separated list of\n"
+		"           <units>, e.g. -u mult=0,1. may be repeated.\n"
+		"-p <h>,... with -s, schedules with each comma separated heuristic\n"
+		"           at once, one thread each, and keeps the schedule whose\n"
+		"           last result lands first (ties go to the first listed).\n"
+		"           every heuristic issues the heaviest ready op first;\n"
+		"           weight (the default) breaks ties by earlier op,\n"
+		"           fanout by more ops waiting on it, pressure by more\n"
+		"           registers freed, and backward schedules the block\n"
+		"           from its last cycle back. all names every heuristic.\n"
+		"  -g <n>   builds the dependency graph on n threads (default 1).\n"
+		"           the graph is the same; ignored with -d.\n"
+		"  -k <n>   allocates the block (as scheduled, with -s) to n\n"
+		"           physical registers r0 to r<n-1> and prints the\n"
+		"           resulting ILOC. spilled values live at addresses from\n"
+		"           32768 up. needs at least 3 registers, or 2 per unit\n"
+		"           plus one when scheduling. registers read before the\n"
+		"           block defines them stay where they are, so must be\n"
+		"           below n.\n"
+		"      -d   disambiguates memory: addresses built from loadI by\n"
+		"           add, sub and lshift are tracked, and memory operations\n"
+		"           are serialized only when their addresses may overlap.\n"
+		"           with --stats, reports the edges and critical path saved.\n"
+		"      -r   removes every dependency graph edge already implied by\n"
+		"           a longer path. weights and schedules are unchanged.\n"
+		" --slack   also prints each node's earliest and latest start\n"
+		"           cycle on unlimited units and the slack between them,\n"
+		"           and a critical path (a longest path, every node of\n"
+		"           which has no slack). with --stats, reports its length.\n"
+		"           takes time linear in the size of the graph.\n"
+		"   --sim   runs what would be printed (the block in order, its\n"
+		"           schedule, or its allocation) on a cycle-accurate\n"
+		"           simulator instead, with memory set by the block's\n"
+		"           //SIM INPUT header, and prints cycles, stalls and\n"
+		"           output. exits with 1 if output differs from the\n"
+		"           block's //OUTPUT header.\n"
+		"  --stats  reports wall time for each phase and counters (tokens,\n"
+		"           edges by kind, virtual registers, ...) on stderr as\n"
+		"           one line of JSON per file.\n"
+		"--recover  on an error in the ILOC, reports it and skips the rest\n"
+		"           of its line instead of stopping, so the other lines\n"
+		"           are still scheduled. exits with 1 if there were any.\n"
+		"           errors are reported on stderr as file:line:pos.\n"
+		"--cache[=<dir>]\n"
+		"           keeps the parsed and renamed IR of each file in a\n"
+		"           binary cache, <filename>.irc or a file in <dir>, and\n"
+		"           reuses it while the file's contents are unchanged.\n"
+		"      -b   batch mode. schedules every file named, and every \".i\"\n"
+		"           file below every directory named, on a pool of threads.\n"
+		"           each result is written to <dir>/<path>.out, where\n"
+		"           <path> is the file's path below the directory named\n"
+		"           (or its name, if named itself).\n"
+		"  -o <dir> directory batch results are written to (default .).\n"
+		"  -j <n>   number of batch worker threads (default: one per\n"
+		"           hardware thread).\n"
+		"  -w <n>   streaming mode. reads the ILOC (\"-\" for stdin) n\n"
+		"           instructions at a time, printing weights or schedule\n"
+		"           as instructions leave the window, so memory stays\n"
+		"           bounded by n. results match the whole block once n\n"
+		"           covers it. cannot be combined with -b, -k, -p, -g, -d,\n"
+		"           -r, --slack, --sim, --stats or --cache.\n"
+		"--serve[=<socket>]\n"
+		"           server mode. answers requests on stdin, or on connections\n"
+		"           to a Unix domain socket at <socket> (-j threads), until\n"
+		"           killed. a request is \"file <path>\" or \"iloc <length>\"\n"
+		"           followed by that many bytes of ILOC, on a line of its own;\n"
+		"           the response is \"ok <length>\" (or \"error <length>\")\n"
+		"           followed by the report sched would print with the same\n"
+		"           options. cannot be combined with -b or -w.\n"
 		"filename   the name of a file containing ILOC code to be compiled.\n"
 		"           unless the help option is invoked, this will always be the\n"
 		"           last option.\n";
@@ -54,54 +153,304 @@ int main(int argc, char* argv[]) {
 		cerr << "error: not enough arguments"
 			<< endl << usage << endl;
 		return 1;
-	} else if (argc > MAX_ARGS) {
-		cerr << "error: too many arguments"
-			<< endl << usage << endl;
-		return 1;
+	}
+
 	// parse arguments
-	} else {
+	for (int a = 1; a < argc; ++a) {
 		// parse -h & --help
-		if (strcmp(argv[1], "-h") == 0 ||
-			strcmp(argv[1], "--help") == 0) {
+		if (strcmp(argv[a], "-h") == 0 ||
+			strcmp(argv[a], "--help") == 0) {
 				cout << help << endl;
 				return 0;
-		// parse filename for argc == 2
-		} else if (validFile(argv[1]))
-			infile = argv[1];
-		// bad filename
-		else if (argc == 2) {
-			cerr << "error: invalid filename: " 
-				<< argv[1] << endl << usage << endl;
-			return 1;
+		// parse -s
+		} else if (strcmp(argv[a], "-s") == 0)
+			opts.schedule = true;
+		// parse -d
+		else if (strcmp(argv[a], "-d") == 0)
+			opts.disambiguate = true;
+		// parse -r
+		else if (strcmp(argv[a], "-r") == 0)
+			opts.reduce = true;
+		// parse --slack
+		else if (strcmp(argv[a], "--slack") == 0)
+			opts.slack = true;
+		// parse --sim
+		else if (strcmp(argv[a], "--sim") == 0)
+			opts.simulate = true;
+		// parse --stats
+		else if (strcmp(argv[a], "--stats") == 0)
+			opts.stats = true;
+		// parse --recover
+		else if (strcmp(argv[a], "--recover") == 0)
+			opts.recover = true;
+		// parse --cache[=<dir>]
+		else if (strncmp(argv[a], "--cache", 7) == 0 &&
+				(argv[a][7] == '\0' || argv[a][7] == '=')) {
+			opts.cache = true;
+			if (argv[a][7] == '=') {
+				opts.cacheDir = argv[a] + 8;
+				if (!validDir(opts.cacheDir)) {
+					cerr << "error: invalid cache directory: "
+						<< opts.cacheDir << endl << usage << endl;
+					return 1;
+				}
+			}
+		// parse --serve[=<socket>]
+		} else if (strncmp(argv[a], "--serve", 7) == 0 &&
+				(argv[a][7] == '\0' || argv[a][7] == '=')) {
+			serve = true;
+			if (argv[a][7] == '=')
+				socketPath = argv[a] + 8;
+		// parse -b
+		} else if (strcmp(argv[a], "-b") == 0)
+			batch = true;
+		// parse -o <dir>
+		else if (strcmp(argv[a], "-o") == 0 && a + 1 < argc) {
+			outdir = argv[++a];
+			if (!validDir(outdir)) {
+				cerr << "error: invalid output directory: "
+					<< outdir << endl << usage << endl;
+				return 1;
+			}
+		// parse -j <n>
+		} else if (strcmp(argv[a], "-j") == 0 && a + 1 < argc) {
+			threads = atoi(argv[++a]);
+			if (threads < 1) {
+				cerr << "error: invalid number of threads: "
+					<< argv[a] << endl << usage << endl;
+				return 1;
+			}
+		// parse -f <n>
+		} else if (strcmp(argv[a], "-f") == 0 && a + 1 < argc) {
+			width = atoi(argv[++a]);
+			if (width < 1 || width > MAX_UNITS) {
+				cerr << "error: invalid number of functional units: "
+					<< argv[a] << endl << usage << endl;
+				return 1;
+			}
+		// parse -k <n>
+		} else if (strcmp(argv[a], "-k") == 0 && a + 1 < argc) {
+			registers = atoi(argv[++a]);
+			if (registers < 1) {
+				cerr << "error: invalid number of registers: "
+					<< argv[a] << endl << usage << endl;
+				return 1;
+			}
+		// parse -u <op>=<units>
+		} else if (strcmp(argv[a], "-u") == 0 && a + 1 < argc) {
+			pair<int, unsigned> rule;
+			if (!parseUnits(argv[++a], rule.first, rule.second)) {
+				cerr << "error: invalid unit restriction: "
+					<< argv[a] << endl << usage << endl;
+				return 1;
+			}
+			unitRules.push_back(rule);
+		// parse -w <n>
+		} else if (strcmp(argv[a], "-w") == 0 && a + 1 < argc) {
+			window = atoi(argv[++a]);
+			if (window < 1) {
+				cerr << "error: invalid window size: "
+					<< argv[a] << endl << usage << endl;
+				return 1;
+			}
+		// parse -g <n>
+		} else if (strcmp(argv[a], "-g") == 0 && a + 1 < argc) {
+			opts.graphThreads = atoi(argv[++a]);
+			if (opts.graphThreads < 1) {
+				cerr << "error: invalid number of graph threads: "
+					<< argv[a] << endl << usage << endl;
+				return 1;
+			}
+		// parse -p <h>[,<h>...]
+		} else if (strcmp(argv[a], "-p") == 0 && a + 1 < argc) {
+			if (!parseHeuristics(argv[++a], opts.heuristics)) {
+				cerr << "error: invalid heuristics: "
+					<< argv[a] << endl << usage << endl;
+				return 1;
+			}
+		// file (or, in batch mode, directory) names; - for stdin
+		} else if (argv[a][0] != '-' || strcmp(argv[a], "-") == 0)
+			infiles.push_back(argv[a]);
 		// bad argument
-		} else {
+		else {
 			cerr << "error: invalid argument: "
-				<< argv[1] << endl << usage << endl;
+				<< argv[a] << endl << usage << endl;
 			return 1;
 		}
+	}
+
+	// ensure correct number of file names
+	if (serve && (batch || window || !infiles.empty())) {
+		cerr << "error: --serve takes no file names and cannot be combined "
+			"with -b or -w" << endl << usage << endl;
+		return 1;
+	} else if (infiles.empty() && !serve) {
+		cerr << "error: not enough arguments"
+			<< endl << usage << endl;
+		return 1;
+	} else if (!batch && infiles.size() > 1) {
+		cerr << "error: too many arguments"
+			<< endl << usage << endl;
+		return 1;
+	} else if (window && (batch || registers || opts.disambiguate ||
+			opts.reduce || opts.slack || opts.simulate || opts.stats ||
+			opts.cache || opts.heuristics != Options().heuristics || opts.graphThreads > 1)) {
+		cerr << "error: -w cannot be combined with -b, -k, -p, -g, -d, -r, "
+			"--slack, --sim, --stats or --cache" << endl << usage << endl;
+		return 1;
+	} else if (!batch && !serve && !(window && infiles[0] == "-") &&
+			!validFile(infiles[0])) {
+		cerr << "error: invalid filename: " 
+			<< infiles[0] << endl << usage << endl;
+		return 1;
+	}
+
+	// build machine model, applying -u restrictions
+	opts.machine = Machine {width};
+	for (auto& rule : unitRules) {
+		if (rule.second >> width) {
+			cerr << "error: unit restriction names a unit beyond -f "
+				<< width << endl << usage << endl;
+			return 1;
+		}
+		opts.machine.units[rule.first] = rule.second;
+	}
+
+	if (registers && registers < opts.minRegisters()) {
+		cerr << "error: -k needs at least " << opts.minRegisters()
+			<< " registers" << endl << usage << endl;
+		return 1;
+	}
+	opts.registers = registers;
 
+	// create directories named, now that every option is valid
+	if (!opts.cacheDir.empty() && !makeDir(opts.cacheDir)) {
+		cerr << "error: cannot create cache directory: "
+			<< opts.cacheDir << endl;
+		return 1;
+	} else if (batch && !makeDir(outdir)) {
+		cerr << "error: cannot create output directory: "
+			<< outdir << endl;
+		return 1;
 	}
 
+	// answer requests until killed (or stdin ends)
+	if (serve) {
+		Server server {opts, threads};
+		if (socketPath.empty()) {
+			server.serve(cin, cout);
+			return 0;
+		}
+		return server.listen(socketPath) ? 0 : 1;
+	}
 
-	// Create Scheduler object.
-	// all functionality is actived by constructor.
-	Scheduler scheduler {infile};
+	// schedule every file on a pool of threads
+	if (batch)
+		return Batch {infiles, outdir, threads, opts}.run() ? 1 : 0;
 
-	// print output.
-	cout << scheduler;
+	// stream the file through a window
+	if (window) {
+		Window w {infiles[0], window, opts.machine, opts.recover};
+		if (opts.schedule)
+			w.printSchedule(cout);
+		else
+			w.printWeights(cout);
+		for (const Diagnostic& d : w.diagnostics())
+			cerr << d;
+		return w.diagnostics().empty() ? 0 : 1;
+	}
 
-	return 0;
+	// schedule the file and print output.
+	return runScheduler(infiles[0], opts, cout) ? 0 : 1;
 }
 
 
-// tests for valid file
+// tests for valid file, without opening it
 bool validFile(string filename) {
-	bool valid = false;
-	ifstream f(filename);
-	if (f) {
-		valid = true;
-		f.close();
+	struct stat st;
+	return stat(filename.c_str(), &st) == 0 && !S_ISDIR(st.st_mode);
+}
+
+
+
+// tests for a directory, or for nothing at all where
+// makeDir could create one
+bool validDir(const string& dir) {
+	struct stat st;
+	if (stat(dir.c_str(), &st) == 0)
+		return S_ISDIR(st.st_mode);
+	return errno == ENOENT;
+}
+
+
+
+// creates dir if it is missing; returns
+// whether it is a directory now
+bool makeDir(const string& dir) {
+	struct stat st;
+	if (stat(dir.c_str(), &st) == 0)
+		return S_ISDIR(st.st_mode);
+	return mkdir(dir.c_str(), 0755) == 0;
+}
+
+
+
+// parses an -u argument of the form <op>=<u>[,<u>...]
+// into an Opcode and a bitmask of units.
+bool parseUnits(const char* arg, int& op, unsigned& mask) {
+	const char* eq = strchr(arg, '=');
+	if (!eq)
+		return false;
+
+	op = INVALID;
+	for (int o = load; o <= nop; ++o)
+		if (string(arg, eq) == opcodeNames[o])
+			op = o;
+	if (op == INVALID)
+		return false;
+
+	mask = 0;
+	const char* p = eq + 1;
+	while (isdigit(*p)) {
+		int u = 0;
+		while (isdigit(*p))
+			u = u * 10 + (*p++ - '0');
+		if (u >= MAX_UNITS)
+			return false;
+		mask |= 1u << u;
+		if (*p == ',')
+			++p;
 	}
-	return valid;
+	return *p == '\0' && mask != 0;
 }
 
+
+
+// parses an -p argument: "all", or a comma separated
+// list of Heuristic names, into the Heuristics to race in
+// the order given (ties go to the first). a name given
+// twice is raced once.
+bool parseHeuristics(const char* arg, vector<Heuristic>& list) {
+	list.clear();
+	if (strcmp(arg, "all") == 0) {
+		for (int h = 0; h < NumHeuristics; ++h)
+			list.push_back((Heuristic)h);
+		return true;
+	}
+
+	const char* p = arg;
+	while (*p) {
+		const char* comma = strchr(p, ',');
+		string name = comma ? string(p, comma) : string(p);
+		int h = INVALID;
+		for (int i = 0; i < NumHeuristics; ++i)
+			if (name == heuristicNames[i])
+				h = i;
+		if (h == INVALID)
+			return false;
+		if (find(list.begin(), list.end(), (Heuristic)h) == list.end())
+			list.push_back((Heuristic)h);
+		p = comma ? comma + 1 : p + name.size();
+	}
+	return !list.empty();
+}
@@ -14,27 +14,36 @@
 #include "parser.h"
 
 
-//// Register constructors ////
-
-
-// constructor for Instruction.src1
-Register::Register(bool o)
-		:sr{INVALID}, isReg{false}, isOp1{o},
-		vr{INVALID}, pr{INVALID}, nu{INVALID} {}
-
-
-// default constructor
-// all arguments declared with defaults
-Register::Register(int s, bool r, bool o, int v, int p, int n)
-					:sr{s}, isReg{r}, isOp1{o}, vr{v}, pr{p}, nu{n} {}
-
-
 //// Instruction constructor ////
 
 
-// overloaded constructor
-Instruction::Instruction(Opcode o, Register s1, Register s2, Register d)
-			:op{o}, src1{s1}, src2{s2}, dest{d} {}
+// overloaded constructor. registers are implied by
+// the Opcode: load reads src1, store reads both sources,
+// arithmetic reads both and writes dest, and loadI
+// writes dest from its constant.
+Instruction::Instruction(Opcode o, int s1, int s2, int d)
+			:operand{s1, s2, d}, op{(uint8_t)o}, regs{0} {
+	switch (o) {
+		case load:
+			regs = 1 << Src1 | 1 << Dest;
+			break;
+		case loadI:
+			regs = 1 << Dest;
+			break;
+		case store:
+			regs = 1 << Src1 | 1 << Src2;
+			break;
+		case add:
+		case sub:
+		case mult:
+		case lshift:
+		case rshift:
+			regs = 1 << Src1 | 1 << Src2 | 1 << Dest;
+			break;
+		default:
+			break;
+	}
+}
 
 
 
@@ -43,46 +52,111 @@ Instruction::Instruction(Opcode o, Register s1, Register s2, Register d)
 
 // constructor (public)
 // takes file name and "scanner print" bool to construct Scanner,
-Parser::Parser(string infile, bool sp) :scanner{infile, sp} {
+// whether to stream the file rather than parse it whole, and
+// whether to recover from errors.
+Parser::Parser(string infile, bool sp, bool stream, bool rec)
+		:scanner{infile, sp, stream}, recover{rec} {
 	// parse until EOF or error
+	if (!stream)
+		parse();
+}
+
+
+// buffer constructor (public)
+// takes text in memory, the name to report errors under,
+// and "scanner print" bool to construct Scanner, and
+// whether to recover from errors.
+Parser::Parser(const char* text, size_t length, const string& name, bool sp,
+		bool rec) :scanner{text, length, name, sp}, recover{rec} {
 	parse();
 }
 
 
+// returns number of Tokens the Scanner produced (public)
+long Parser::tokens() const {
+	return scanner.tokens;
+}
+
+
+// returns the input the Scanner reads from (public)
+const char* Parser::data() const {
+	return scanner.data();
+}
+
+
+// returns the length in bytes of the input (public)
+size_t Parser::size() const {
+	return scanner.size();
+}
+
+
+// parses the next Instruction into i (public)
+// returns false at EOF, or at the first error unless
+// recovering. each error is added to diagnostics; when
+// recovering, its line is skipped and parsing goes on
+// from the next.
+bool Parser::next(Instruction& i) {
+	while (true) {
+		try {
+			return scan(i);
+		} catch (const Diagnostic& d) {
+			diagnostics.push_back(d);
+			if (!recover || !scanner.skipLine())
+				return false;
+		}
+	}
+}
+
+
 // main parse function (private; called from constructor)
-// requests an instruction token, then builds an
-// Instruction based on its Opcode and adds it to the
-// end of the intermediate representation (intRep)
+// adds each Instruction next() parses to the end of the
+// intermediate representation (intRep). loops rather
+// than recursing so stack usage does not grow with the
+// length of the block.
 void Parser::parse() {
+	// size IR from input length so it rarely reallocates
+	intRep.reserve(scanner.size() / EST_LINE_LENGTH + 1);
+
+	Instruction i;
+	while (next(i))
+		intRep.push_back(i);
+}
+
+
+// parses the next Instruction into i (private)
+// requests an instruction token, then fills in the
+// operands its Opcode calls for. returns false at EOF;
+// the Scanner throws on bad input.
+bool Parser::scan(Instruction& i) {
 	// scan next Instruction
 	Token t = scanner.scanInstruction();
 	// check for EOF (only time Invalid Token is returned)
 	if (t.cat == INVALID)
-		return;
+		return false;
 
-	Instruction i {(Opcode)t.value};
+	i = Instruction {(Opcode)t.value};
 	switch (i.op) {
 
 		case load:
-			i.src1 = Register {(scanner.scanRegister()).value, true, true};
+			i.operand[Src1] = scanner.scanRegister().value;
 			scanner.scanArrow();
-			i.dest = Register {(scanner.scanRegister()).value, true};
+			i.operand[Dest] = scanner.scanRegister().value;
 			break;
 
 		case loadI:
-			i.src1 = Register {(scanner.scanConstant()).value, false, true};
+			i.operand[Src1] = scanner.scanConstant().value;
 			scanner.scanArrow();
-			i.dest = Register {(scanner.scanRegister()).value, true};
+			i.operand[Dest] = scanner.scanRegister().value;
 			break;
 
 		case store:
-			i.src1 = Register {(scanner.scanRegister()).value, true, true};
+			i.operand[Src1] = scanner.scanRegister().value;
 			scanner.scanArrow();
-			i.src2 = Register {(scanner.scanRegister()).value, true};
+			i.operand[Src2] = scanner.scanRegister().value;
 			break;
 
 		case output:
-			i.src1 = Register {(scanner.scanConstant()).value, false, true};
+			i.operand[Src1] = scanner.scanConstant().value;
 			break;
 
 		case nop:
@@ -90,19 +164,14 @@ void Parser::parse() {
 
 		// arithmetic operations
 		default:
-			i.src1 = Register {(scanner.scanRegister()).value, true, true};
+			i.operand[Src1] = scanner.scanRegister().value;
 			scanner.scanComma();
-			i.src2 = Register {(scanner.scanRegister()).value, true};
+			i.operand[Src2] = scanner.scanRegister().value;
 			scanner.scanArrow();
-			i.dest = Register {(scanner.scanRegister()).value, true};
+			i.operand[Dest] = scanner.scanRegister().value;
 			break;
 	}
-
-	// add Instruction to end of IR
-	intRep.push_back(i);
-
-	// continue parsing
-	parse();
+	return true;
 }
 
 
@@ -111,58 +180,7 @@ void Parser::parse() {
 
 
 
-// Register pretty print
-// first sr field for an instruction: 12 spaces
-//	- up to INT_MAX with 1 space padding
-// all other register fields: 6 spaces
-//	- register value up to 1000 with 1 space padding
-ostream& operator<<(ostream& os, const Register& r) {
-	string noReg = "  -   ";
-	// print source register
-	if (r.sr == INVALID) {
-		os << noReg;
-		if (r.isOp1)
-			os << "      ";
-	} else if (r.isReg) {
-		os << " r";
-		// set field width
-		if (r.isOp1)
-			os << setw(10);
-		else
-			os << setw(4);
-		os << left << r.sr;
-	} else
-		os << " " << setw(11) << left << r.sr;
-	os << "|";
-
-	// print virtual register
-	if (r.vr == INVALID)
-		os << noReg;
-	else
-		os << " v" << setw(4) << left << r.vr;
-	os << "|";
-
-	// print physical register
-	if (r.pr == INVALID)
-		os << noReg;
-	else
-		os << " r" << setw(4) << left << r.pr;
-	os << "|";
-
-	// print next use
-	if (r.nu == INVALID)
-		os << noReg;
-	else if (r.nu == INT_MAX)
-		os << " INF  ";
-	else
-		os << " " << setw(5) << left << r.nu;
-	os << "||";
-
-	return os;
-}
-
-
-// Instruction pretty print
+// Instruction pretty print, naming registers as written
 ostream& operator<<(ostream& os, const Instruction& i) {
 	// set ostream variables
 	os << " " << setw(7) << left;
@@ -173,7 +191,7 @@ ostream& operator<<(ostream& os, const Instruction& i) {
 			break;
 		case loadI:
 			os << "loadI "
-				<< setw(5) << i.src1.sr;
+				<< setw(5) << i.operand[Src1];
 			break;
 		case store:
 			os << "store";
@@ -195,7 +213,7 @@ ostream& operator<<(ostream& os, const Instruction& i) {
 			break;
 		case output:
 			os << "output " 
-				<< i.src1.sr << endl;
+				<< i.operand[Src1] << endl;
 			return os;
 		case nop:
 			os << "nop"
@@ -207,12 +225,12 @@ ostream& operator<<(ostream& os, const Instruction& i) {
 	}
 
 	// print src1
-	if (i.src1.isReg)
-		os << "r" << setw(4) << i.src1.vr;
+	if (i.isReg(Src1))
+		os << "r" << setw(4) << i.operand[Src1];
 
 	// print src2
-	if (i.src2.isReg && i.op != store)
-		os << ", r" << setw(4) << i.src2.vr;
+	if (i.isReg(Src2) && i.op != store)
+		os << ", r" << setw(4) << i.operand[Src2];
 	else
 		os << setw(7) << " ";
 
@@ -222,9 +240,9 @@ ostream& operator<<(ostream& os, const Instruction& i) {
 	// print dest
 	os << "r";
 	if (i.op == store)
-		os << i.src2.vr;
+		os << i.operand[Src2];
 	else
-		os << i.dest.vr;
+		os << i.operand[Dest];
 
 	// newline
 	os << endl;
@@ -2,10 +2,10 @@
  *                                                       *
  * parser.h                                              *
  *                                                       *
- * Contains declarations for Register and Instruction    *
- * structures and Parser class, as well as all necessary *
- * includes and using statements not already present in  *
- * scanner.h.                                            *
+ * Contains declarations for Operand enumeration,        *
+ * Instruction structure and Parser class, as well as    *
+ * all necessary includes and using statements not       *
+ * already present in scanner.h.                         *
  *                                                       *
  * Written by: Austin James Lee                          *
  *                                                       *
@@ -14,57 +14,75 @@
 #pragma once
 
 #include "scanner.h"
-#include <list>
+#include <vector>
 #include <iomanip>
+#include <cstdint>	// int32_t, uint8_t
 
-using std::list;
+#define EST_LINE_LENGTH 24	// estimated bytes of input per instruction
+
+using std::vector;
 using std::setw;
 using std::left;
 
 
-//// Register structure ////
+//// Operand enumeration ////
 
-struct Register {
-	// constructor. takes bool used to set op1
-	Register(bool o);
-	// constructor. takes values in order they are declared
-	Register(int = INVALID, bool = false, bool = false,
-			int = INVALID, int = INVALID, int = INVALID);
-	int sr;		// source register
-	bool isReg;	// valid register?
-	bool isOp1;	// indicates if src1 (purely for printing)
-	int vr;		// virtual register
-	int pr;		// physical register
-	int nu;		// index of next use of this register
-	// allow for simple and pretty printing
-	friend ostream& operator<<(ostream& os, const Register& r);
+// positions of an Instruction's operands. side arrays
+// indexed by Operand keep NumOperands entries per
+// Instruction, e.g. vr[NumOperands * n + Dest].
+enum Operand {
+	Src1,
+	Src2,
+	Dest,
+	NumOperands
 };
 
 
 //// Instruction structure ////
 
+// packed into 16 bytes. each operand holds a register
+// number, or for src1 of loadI and output, a constant.
+// virtual and physical registers are kept in side arrays
+// by the phases that assign them.
 struct Instruction {
-	// constructor. takes values in order listed.
+	// constructor. takes values in order listed and
+	// sets regs from the Opcode.
 	Instruction(Opcode = (Opcode)INVALID,
-		Register={true}, Register={}, Register={});
-	Opcode op;				
-	Register src1;
-	Register src2;
-	Register dest;
-	int label;
+		int = INVALID, int = INVALID, int = INVALID);
+	int32_t operand[NumOperands];	// indexed by Operand
+	uint8_t op;		// Opcode
+	uint8_t regs;	// bit o set when operand o is a register
+	bool isReg(int o) const { return regs >> o & 1; }
 	// allow for simple and pretty printing
 	friend ostream& operator<<(ostream& os, const Instruction& i);
 };
 
+static_assert(sizeof(Instruction) == 16, "Instruction must pack into 16 bytes");
+
 
 //// Parser class ////
 
 class Parser {
 	public:
-		// constructor (calls parse)
-		Parser(string infile, bool = false);
-		list<Instruction> intRep;	// list representing IR
+		// constructor (calls parse). when streaming, leaves
+		// intRep empty and Instructions are taken with next().
+		// errors stop the parse unless recover is set, when
+		// the rest of the line is skipped instead
+		Parser(string infile, bool = false, bool stream = false,
+			bool recover = false);
+		// buffer constructor (calls parse). parses text[0, length)
+		// in place; name is used in error messages
+		Parser(const char* text, size_t length, const string& name,
+			bool = false, bool recover = false);
+		vector<Instruction> intRep;	// vector representing IR
+		vector<Diagnostic> diagnostics;	// errors found, in order
+		long tokens() const;		// number of Tokens scanned
+		const char* data() const;	// input scanned, unless streaming
+		size_t size() const;		// its length in bytes
+		bool next(Instruction& i);	// parses one Instruction; false at EOF
 	private:
 		Scanner scanner;	// Scanner used to scan tokens
+		bool recover;		// skip bad lines instead of stopping
 		void parse();		// main parse function
+		bool scan(Instruction& i);	// next() without catching errors
 };
@@ -4,8 +4,8 @@
  *                                                                 *
  * Contains implementations for everything declared in scanner.h.  *
  * Methods appear in the same order as they do in scanner.h with   *
- * the exception of Token's print function, which is at the end of *
- * the file.                                                       *
+ * the exception of the Token and Diagnostic print functions,      *
+ * which are at the end of the file.                               *
  *                                                                 *
  * Written by: Austin James Lee                                    *
  *                                                                 *
@@ -14,6 +14,56 @@
 #include "scanner.h"
 
 
+// ILOC spelling of each Opcode
+const char* const opcodeNames[] = {
+	"load", "loadI", "store", "add", "sub",
+	"mult", "lshift", "rshift", "output", "nop"
+};
+
+
+// slot of an opcode in LexTables::keyword. no two opcodes
+// share a first letter and length, and this maps each of
+// those pairs to a distinct slot.
+#define KEYWORD_SLOT(first, length) (((first) + 3 * (length)) & 15)
+
+
+// tables consulted by the scanner's fast paths:
+// a CharClass bitmask for every byte, and a perfect
+// hash from (first letter, length) to Opcode along
+// with that Opcode's spelling packed into 8 bytes
+// and a mask covering the bytes of the spelling.
+static const struct LexTables {
+	unsigned char cls[256];
+	int keyword[16];
+	uint64_t spelling[16];
+	uint64_t mask[16];
+	LexTables() :cls{}, spelling{}, mask{} {
+		cls[(int)' '] = cls[(int)'\t'] = WhiteSpace;
+		cls[(int)'\n'] = cls[(int)'\r'] = NewLine;
+		cls[(int)'\f'] = cls[(int)'\v'] = NewLine;
+		for (int c = '0'; c <= '9'; ++c)
+			cls[c] = Digit;
+		for (int c = 'a'; c <= 'z'; ++c)
+			cls[c] = cls[c - 'a' + 'A'] = Alpha;
+		for (int& k : keyword)
+			k = INVALID;
+		for (int op = load; op <= nop; ++op) {
+			int len = strlen(opcodeNames[op]);
+			int slot = KEYWORD_SLOT(opcodeNames[op][0], len);
+			keyword[slot] = op;
+			memcpy(&spelling[slot], opcodeNames[op], len);
+			memset(&mask[slot], 0xFF, len);
+		}
+	}
+} tables;
+
+
+// true when c (a character or EOF) is in class cls
+static inline bool is(int c, int cls) {
+	return c != EOF && (tables.cls[(unsigned char)c] & cls);
+}
+
+
 //// Token constructors ////
 
 
@@ -32,46 +82,79 @@ Token::Token(TokenCat tc, int v) :cat{tc}, value{v} {}
 
 
 // Scanner default constructor
-Scanner::Scanner() :infile{""}, print{false}, ln{-1}, pos{-1} {}
+Scanner::Scanner() :tokens{0}, infile{""}, buf{nullptr}, cur{nullptr},
+		end{nullptr}, mapped{0}, fd{INVALID}, borrowed{false}, print{false},
+		ln{-1}, pos{-1}, resync{false} {}
 
 
 // Scanner constructor
-// takes input file's name and opens ifstream.
+// takes input file's name and maps it into memory, or if
+// stream is set, opens it (stdin for "-") to be read a
+// chunk at a time so memory use does not grow with it.
 // also takes bool indicating whether -t option was passed.
 // initializes line to 1 and pos to 0.
-Scanner::Scanner(string f, bool p) :infile{f}, print{p}, ln{1}, pos{0} {
-	input.open(infile);
+Scanner::Scanner(string f, bool p, bool stream) :tokens{0}, infile{f},
+		buf{nullptr}, cur{nullptr}, end{nullptr}, mapped{0}, fd{INVALID},
+		borrowed{false}, print{p}, ln{1}, pos{0}, resync{false} {
+	if (!stream) {
+		mapInput();
+		return;
+	}
+	fd = f == "-" ? 0 : open(f.c_str(), O_RDONLY);
+	refill();
 }
 
 
+// Scanner buffer constructor
+// scans the caller's text without copying or opening
+// anything; name stands in for the file name in errors.
+Scanner::Scanner(const char* text, size_t length, const string& name, bool p)
+		:tokens{0}, infile{name}, buf{text}, cur{text}, end{text + length},
+		mapped{0}, fd{INVALID}, borrowed{true}, print{p}, ln{1}, pos{0},
+		resync{false} {}
+
+
 // Scanner copy constructor
-Scanner::Scanner(const Scanner& s)
-		:infile{s.infile}, print{s.print}, ln{s.ln}, pos{s.pos} {
-	input.open(infile);
+// maps the same file (or shares the same borrowed buffer)
+// and resumes at the same position.
+Scanner::Scanner(const Scanner& s) :tokens{s.tokens}, infile{s.infile},
+		buf{nullptr}, cur{nullptr}, end{nullptr}, mapped{0}, fd{INVALID},
+		borrowed{s.borrowed}, print{s.print}, ln{s.ln}, pos{s.pos},
+		resync{s.resync} {
+	if (borrowed) {
+		buf = s.buf;
+		end = s.end;
+	} else
+		mapInput();
+	if (s.buf && buf)
+		cur = buf + (s.cur - s.buf);
 }
 
 
 // Scanner deconstructor (public)
-// closes ifstream before destroying Scanner object.
+// unmaps input before destroying Scanner object.
 Scanner::~Scanner() {
-	input.close();
+	if (mapped)
+		munmap(const_cast<char*>(buf), mapped);
+	if (fd > 0)
+		close(fd);
 }
 
 
 // scans and returns an arbitrary Token from input.
 // checks for EOF and returns Invalid Token if found
-// calls Scanner::error(string msg), terminating on bad input.
+// calls Scanner::error(string msg) on bad input.
 Token Scanner::scanToken() {
 	// remove WS, NL, and check for EOF
 	removeWS();
 	if (ensureNL()) {
 		get();
 		return scanToken();
-	} else if (input.peek() == EOF)
+	} else if (peek() == EOF)
 		return Token();
 
 	Token ret;
-	switch (input.peek()) {
+	switch (peek()) {
 
 		case '=':
 			get();
@@ -92,9 +175,9 @@ Token Scanner::scanToken() {
 			break;
 
 		default:
-			if (isalpha(input.peek()))
+			if (is(peek(), Alpha))
 				ret = scanAlpha();
-			else if (isdigit(input.peek()))
+			else if (is(peek(), Digit))
 				ret = Token {Constant, scanNumber()};
 			else
 				error("invalid character to start Token");
@@ -104,6 +187,7 @@ Token Scanner::scanToken() {
 	// remove trailing whitespace
 	removeWS();
 
+	++tokens;
 	if (print)
 		cerr << ret << endl;
 
@@ -117,7 +201,7 @@ Token Scanner::scanToken() {
 // Token if -t was passed, and returns Instruction
 // Token.
 // checks for EOF, returning Invalid Token if found.
-// terminates on bad input via Scanner::error().
+// reports bad input via Scanner::error().
 Token Scanner::scanInstruction() {
 	// this block ensures all instructions begin on a new line:
 	//	- removes any leading whitespace
@@ -130,28 +214,35 @@ Token Scanner::scanInstruction() {
 /*
 	if (ensureNL()) {
 		get();
-	} else if (input.peek() == '/') {
+	} else if (peek() == '/') {
 		removeComment();
 		return scanInstruction();
 */
-	if (ensureNL() || input.peek() == '/') {
+	if (ensureNL() || peek() == '/') {
 		do {
 			if (ensureNL())
 				get();
-			if (input.peek() == '/')
+			// a streamed chunk ends only after a new line
+			if (peek() == EOF)
+				refill();
+			if (peek() == '/')
 				removeComment();
 		} while (ensureNL());
-	} else if (ln != 1)
+	} else if (ln != 1 && !resync)
 		error("all ILOC operations must begin on a new line");
+	resync = false;
 
 	// check for eof
-	if (input.peek() == EOF)
+	if (peek() == EOF)
 		return Token();
 
 	removeWS();
 
-	Token ret = Token {Instruct, INT_MIN};
-	switch (get()) {
+	// whole opcodes are matched at once. anything else is
+	// rescanned a character at a time, which yields the
+	// same diagnostic the scanner has always given.
+	Token ret = Token {Instruct, matchOpcode()};
+	if (ret.value == INVALID) switch (get()) {
 
 		case 's':
 			switch (get()) {
@@ -183,7 +274,7 @@ Token Scanner::scanInstruction() {
 				case 'o':
 					if (get() == 'a' && get() == 'd') {
 						// "loadI"
-						if (input.peek() == 'I') {
+						if (peek() == 'I') {
 							get();
 							ret.value = loadI;
 						// "load"
@@ -259,6 +350,7 @@ Token Scanner::scanInstruction() {
 	else if (ret.value != nop)	// bc nop can be immediately followed by NL
 		error("no whitespace following valid opcode");
 
+	++tokens;
 	if (print)
 		cerr << ret << endl;
 
@@ -269,20 +361,23 @@ Token Scanner::scanInstruction() {
 // scans a register, removes trailing
 // whitespace, prints Token if -t was passed,
 // and returns a Register Token.
-// terminates on bad input via Scanner::error().
+// reports bad input via Scanner::error().
 //
 // ret defined as invalid Token, but only valid
 // Register Token will be returned due to error().
 Token Scanner::scanRegister() {
 	Token ret = Token();
-	if (get() == 'r') {
-		if (isdigit(input.peek())) {
+	if (accept('r')) {
+		if (is(peek(), Digit)) {
 			ret = Token {Reg, scanNumber()};
 			removeWS();
 		} else
 			error("expected register number");
-	} else
+	} else {
+		get();
 		error("expected register");
+	}
+	++tokens;
 	if (print)
 		cerr << ret << endl;
 	return ret;
@@ -292,17 +387,18 @@ Token Scanner::scanRegister() {
 // scans a numerical constant, removes trailing
 // whitespace, prints Token if -t was passed,
 // and returns a Constant Token.
-// terminates on bad input via Scanner::error().
+// reports bad input via Scanner::error().
 //
 // ret defined as invalid Token, but only valid
 // Constant Token will be returned due to error().
 Token Scanner::scanConstant() {
 	Token ret = Token();
-	if (isdigit(input.peek())) {
+	if (is(peek(), Digit)) {
 		ret = Token {Constant, scanNumber()};
 		removeWS();
 	} else
 		error("expected numerical constant");
+	++tokens;
 	if (print)
 		cerr << ret << endl;
 	return ret;
@@ -312,17 +408,20 @@ Token Scanner::scanConstant() {
 // scans an arrow, removes trailing
 // whitespace, prints Token if -t was passed,
 // and returns an Arrow Token.
-// terminates on bad input via Scanner::error().
+// reports bad input via Scanner::error().
 //
 // ret defined as invalid Token, but only valid
 // Arrow Token will be returned due to error().
 Token Scanner::scanArrow() {
 	Token ret = Token();
-	if (get() == '=' && get() == '>') {
+	if (accept('=') && accept('>')) {
 		removeWS();
 		ret = Token {Arrow, -1};
-	} else
+	} else {
+		get();
 		error("expected assignment arrow");
+	}
+	++tokens;
 	if (print)
 		cerr << ret << endl;
 	return ret;
@@ -331,27 +430,136 @@ Token Scanner::scanArrow() {
 
 // scans a comma, removes trailing
 // whitespace, and returns a Comma Token.
-// terminates on bad input via Scanner::error().
+// reports bad input via Scanner::error().
 //
 // ret defined as invalid Token, but only valid
 // Comma Token will be returned due to error().
 Token Scanner::scanComma() {
 	Token ret = Token();
-	if (get() == ',') {
+	if (accept(',')) {
 		removeWS();
 		ret = Token {Comma, -1};
-	} else
+	} else {
+		get();
 		error("expected comma to separate register arguments");
+	}
+	++tokens;
 	if (print)
 		cerr << ret << endl;
 	return ret;
 }
 
 
+// returns length of input in bytes.
+size_t Scanner::size() const {
+	return end - buf;
+}
+
+
+// returns the input being scanned, size() bytes long.
+// when streaming, only the chunk currently read.
+const char* Scanner::data() const {
+	return buf;
+}
+
+
+// called after error() to recover: discards the rest of
+// the line the error was found on (nothing, if the error
+// was the new line itself) so the next instruction is
+// looked for on the line after. returns false if no
+// input is left.
+bool Scanner::skipLine() {
+	resync = true;
+	if (cur == buf || !is(cur[-1], NewLine))
+		while (cur < end && !is(*cur, NewLine)) {
+			++cur;
+			++pos;
+		}
+	return peek() != EOF || refill();
+}
+
+
 //// private Scanner methods ////
 
 
-// extension of std::istream::get()
+// maps infile into memory so the scanner can walk
+// a raw character range instead of calling into an
+// ifstream per character. inputs that cannot be
+// mapped (pipes, character devices, empty files)
+// are read into contents instead.
+// a missing file leaves an empty range, which
+// scans as EOF just as a failed ifstream did.
+void Scanner::mapInput() {
+	int fd = open(infile.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+
+	struct stat st;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		void* m = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (m != MAP_FAILED) {
+			madvise(m, st.st_size, MADV_SEQUENTIAL);
+			mapped = st.st_size;
+			buf = static_cast<const char*>(m);
+		}
+	}
+
+	if (!mapped) {
+		char chunk[65536];
+		ssize_t n;
+		while ((n = read(fd, chunk, sizeof chunk)) > 0)
+			contents.append(chunk, n);
+		buf = contents.data();
+	}
+
+	close(fd);
+	cur = buf;
+	end = buf + (mapped ? mapped : contents.size());
+}
+
+
+// streaming only: replaces the buffer with the whole
+// lines of the next chunk of input, carrying over the
+// partial line the last chunk ended in. at end of input,
+// whatever is left is taken as is. returns false once
+// input is exhausted (or if not streaming).
+bool Scanner::refill() {
+	if (fd < 0)
+		return false;
+
+	contents.erase(0, end - buf);
+	while (true) {
+		char chunk[STREAM_CHUNK];
+		ssize_t n = read(fd, chunk, sizeof chunk);
+		if (n <= 0)
+			break;
+		contents.append(chunk, n);
+		size_t nl = contents.rfind('\n');
+		if (nl != string::npos) {
+			buf = cur = contents.data();
+			end = buf + nl + 1;
+			return true;
+		}
+	}
+
+	// no new line before end of input
+	buf = cur = contents.data();
+	end = buf + contents.size();
+	if (fd > 0)
+		close(fd);
+	fd = INVALID;
+	return cur < end;
+}
+
+
+// returns next input character without consuming it,
+// or EOF at the end of input.
+int Scanner::peek() {
+	return cur < end ? (unsigned char)*cur : EOF;
+}
+
+
+// consumes next input character.
 // adds line/position counting functionality.
 int Scanner::get() {
 	pos++;
@@ -359,59 +567,142 @@ int Scanner::get() {
 		ln++;
 		pos = 0;
 	}
-	return input.get();
+	return cur < end ? (unsigned char)*cur++ : EOF;
 }
 
 
-// extension of std::istream::get(char& c)
-// adds line/position counting functionality.
-istream& Scanner::get(char& c) {
-	c = get();
-	return input;
+// consumes next input character if it is c, which
+// must not be a new line. on a mismatch nothing is
+// consumed, so the caller can get() the offending
+// character before reporting it.
+bool Scanner::accept(char c) {
+	if (cur == end || *cur != c)
+		return false;
+	++cur;
+	++pos;
+	return true;
 }
 
 
 // indicates whether or not next
 // input character is whitespace.
 bool Scanner::ensureWS() {
-	int c = input.peek();
-	return c == ' ' || c == '\t';
+	return is(peek(), WhiteSpace);
 }
 
 
 // indicates whether or not next input 
 // character will produce a new line.
 bool Scanner::ensureNL() {
-	int c = input.peek();
-	return c == '\n' || c == '\r' || c == '\f' || c == '\v';
+	return is(peek(), NewLine);
 }
 
 
-// consumes whitespace from input.
+// consumes whitespace from input. the usual single
+// space is handled a byte at a time; runs longer than
+// WS_SCALAR bytes continue 16 bytes at a time where SSE2
+// is available. whitespace never holds a new line, so
+// only pos moves.
 void Scanner::removeWS() {
-	while (ensureWS())
-		get();
+	const char* p = cur;
+	const char* scalar = end - cur > WS_SCALAR ? cur + WS_SCALAR : end;
+	while (p < scalar && is(*p, WhiteSpace))
+		++p;
+#ifdef __SSE2__
+	const __m128i space = _mm_set1_epi8(' ');
+	const __m128i tab = _mm_set1_epi8('\t');
+	if (p - cur == WS_SCALAR)
+		while (end - p >= 16) {
+			__m128i v = _mm_loadu_si128((const __m128i*)p);
+			unsigned ws = _mm_movemask_epi8(_mm_or_si128(
+				_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)));
+			if (ws != 0xFFFF) {
+				p += __builtin_ctz(~ws);
+				break;
+			}
+			p += 16;
+		}
+#endif
+	while (p < end && is(*p, WhiteSpace))
+		++p;
+	pos += p - cur;
+	cur = p;
 }
 
 
-// checks for "//" then consumes remainder of line
+// checks for "//" then consumes remainder of line,
+// up to (not including) the new line. with SSE2 the
+// end of line is found 16 bytes at a time: the new line
+// characters are exactly the bytes 10 through 13.
 void Scanner::removeComment() {
 	if (get() == '/' && get() == '/') {
-		while (!ensureNL() && input.peek() != EOF)
-			get();
-//		get();
+		const char* p = cur;
+#ifdef __SSE2__
+		const __m128i first = _mm_set1_epi8('\n');
+		const __m128i span = _mm_set1_epi8('\r' - '\n');
+		while (end - p >= 16) {
+			__m128i d = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)p), first);
+			unsigned nl = _mm_movemask_epi8(
+				_mm_cmpeq_epi8(_mm_min_epu8(d, span), d));
+			if (nl) {
+				p += __builtin_ctz(nl);
+				break;
+			}
+			p += 16;
+		}
+#endif
+		while (p < end && !is(*p, NewLine))
+			++p;
+		pos += p - cur;
+		cur = p;
 	} else
 		error("invalid '/'; epected comment");
 }
 
 
-// prints explicit error message to 
-// console and terminates program.
-// to be called when bad input is encountered.
+// table-driven opcode recognizer. measures the run of
+// letters at cur, looks it up by first letter and length,
+// and confirms the spelling with one 8 byte comparison.
+// on a match, consumes the word and returns its Opcode;
+// otherwise consumes nothing and returns INVALID.
+int Scanner::matchOpcode() {
+	const char* p = cur;
+	while (p < end && p - cur <= MAX_OPCODE && is(*p, Alpha))
+		++p;
+	int len = p - cur;
+	if (len == 0 || len > MAX_OPCODE)
+		return INVALID;
+
+	int slot = KEYWORD_SLOT(*cur, len);
+	int op = tables.keyword[slot];
+	if (op == INVALID)
+		return INVALID;
+	if (end - cur >= 8) {
+		uint64_t word;
+		memcpy(&word, cur, 8);
+		if ((word & tables.mask[slot]) != tables.spelling[slot])
+			return INVALID;
+	} else if (strncmp(opcodeNames[op], cur, len) != 0)
+		return INVALID;
+
+	pos += len;
+	cur = p;
+	return op;
+}
+
+
+// throws a Diagnostic naming the current position, or if
+// the character at fault was a new line, its place at the
+// end of the line it ends. to be called when bad input is
+// encountered; Parser catches it, so it goes no further.
 void Scanner::error(string msg) {
-	cerr << infile << ":" << ln << ":" << pos << ": ERROR: "
-		<< msg << endl << "Terminating program." << endl;
-	exit(EXIT_FAILURE);
+	if (cur > buf && is(cur[-1], NewLine)) {
+		const char* start = cur - 1;
+		while (start > buf && !is(start[-1], NewLine))
+			--start;
+		throw Diagnostic {infile, ln - 1, (int)(cur - start), msg};
+	}
+	throw Diagnostic {infile, ln, pos, msg};
 }
 
 
@@ -420,10 +711,19 @@ void Scanner::error(string msg) {
 // digit and does not handle error if not.
 // thus, caller must perform check
 int Scanner::scanNumber() {
-	string num = "";
-	while (isdigit(input.peek()))
-		num += get();
-	return stoi(num);
+	long long num = 0;
+	const char* p = cur;
+	while (p < end && is(*p, Digit)) {
+		num = num * 10 + (*p++ - '0');
+		if (num > INT_MAX) {
+			pos += p - cur;
+			cur = p;
+			error("numerical constant out of range");
+		}
+	}
+	pos += p - cur;
+	cur = p;
+	return (int)num;
 }
 
 
@@ -436,8 +736,8 @@ int Scanner::scanNumber() {
 // arising from recursing on whitespace in default
 // case of scanToken().
 Token Scanner::scanAlpha() {
-	int op = INT_MIN;
-	switch (get()) {
+	int op = matchOpcode();
+	if (op == INVALID) switch (get()) {
 
 		case 's':
 			switch (get()) {
@@ -469,7 +769,7 @@ Token Scanner::scanAlpha() {
 				case 'o':
 					if (get() == 'a' && get() == 'd') {
 						// "loadI"
-						if (input.peek() == 'I') {
+						if (peek() == 'I') {
 							get();
 							op = loadI;
 						// "load"
@@ -495,7 +795,7 @@ Token Scanner::scanAlpha() {
 
 		case 'r':
 			// register
-			if (isdigit(input.peek()))
+			if (is(peek(), Digit))
 				return Token {Reg, scanNumber()};
 			// "rshift"
 			else if (get() == 's' && get() == 'h' &&
@@ -552,7 +852,7 @@ Token Scanner::scanAlpha() {
 }
 
 
-//// Token print method ////
+//// Token and Diagnostic print methods ////
 
 
 // overload of << operator to allow for simple printing
@@ -636,3 +936,10 @@ ostream& operator<<(ostream& os, const Token& t) {
 	return os;
 }
 
+
+// prints a Diagnostic as compilers do:
+// file:line:pos: ERROR: message
+ostream& operator<<(ostream& os, const Diagnostic& d) {
+	return os << d.file << ":" << d.line << ":" << d.pos << ": ERROR: "
+		<< d.message << '\n';
+}
@@ -2,10 +2,10 @@
  *                                                   *
  * scanner.h                                         *
  *                                                   *
- * Contains declarations for TokenCat and Opcode     *
- * enumerations, Token structure, and Scanner class, *
- * as well as all necessary import and using         *
- * statements.                                       *
+ * Contains declarations for TokenCat, Opcode and    *
+ * CharClass enumerations, Token and Diagnostic     *
+ * structures, and Scanner class, as well as all     *
+ * necessary import and using statements.            *
  *                                                   *
  * Written by: Austin James Lee                      *
  *                                                   *
@@ -14,16 +14,31 @@
 #pragma once
 
 #include <iostream> // ostream, cout, endl, istream, cerr
-#include <fstream>	// ifstream
+#include <fstream>	// ifstream, ofstream
 #include <string>
+#include <cstddef>	// size_t
 #include <cctype>	// isdigit(), isspace(), isalpha()
-#include <climits>	// INT_MIN
+#include <climits>	// INT_MIN, INT_MAX
 #include <cstdlib>	// exit(), EXIT_FAILURE
 #include <cstdio>	// EOF
+#include <fcntl.h>		// open()
+#include <unistd.h>		// read(), close()
+#include <sys/mman.h>	// mmap(), munmap(), madvise()
+#include <sys/stat.h>	// fstat()
+#include <cstring>	// strlen(), strncmp(), memcpy(), memset()
+#include <cstdint>	// uint64_t
+#ifdef __SSE2__
+#include <emmintrin.h>	// _mm_cmpeq_epi8(), _mm_movemask_epi8()
+#endif
+
+#define MAX_OPCODE 6	// letters in the longest opcode
+#define WS_SCALAR 4		// whitespace skipped a byte at a time
+#define STREAM_CHUNK 65536	// bytes read at a time when streaming
 
 using std::string;
 using std::ostream;
 using std::ifstream;
+using std::ofstream;
 using std::istream;
 using std::cout;
 using std::endl;
@@ -60,6 +75,20 @@ enum Opcode {
 };
 
 
+/// Opcode names, indexed by Opcode ///
+extern const char* const opcodeNames[];
+
+
+/// Character Classes ///
+// bits of the scanner's character class table
+enum CharClass {
+	WhiteSpace = 1,	// ' ', '\t'
+	NewLine = 2,	// '\n', '\r', '\f', '\v'
+	Digit = 4,
+	Alpha = 8
+};
+
+
 ////// Token structure //////
 
 struct Token {
@@ -72,33 +101,70 @@ struct Token {
 };
 
 
+////// Diagnostic structure //////
+
+// an error in the input, where Scanner found it. thrown by
+// Scanner and collected by Parser, never past it.
+struct Diagnostic {
+	string file;
+	int line;
+	int pos;		// index of character on line
+	string message;
+	// prints as file:line:pos: ERROR: message
+	friend ostream& operator<<(ostream& os, const Diagnostic& d);
+};
+
+
 ////// Scanner class //////
 
 class Scanner {
 	public:
 		Scanner();						// default constructor
-		Scanner(string f, bool=false);	// normal constructor
+		// normal constructor. takes file name ("-" for stdin when
+		// streaming), whether to print Tokens, and whether to read
+		// the input a chunk of lines at a time instead of mapping it
+		Scanner(string f, bool=false, bool stream=false);
+		// buffer constructor. scans text[0, length) in place,
+		// which must outlive the Scanner; name is used in errors
+		Scanner(const char* text, size_t length, const string& name,
+			bool=false);
 		Scanner(const Scanner& s);		// copy constructor
-		~Scanner();				// deconstructor, closes input file stream
+		Scanner& operator=(const Scanner&) = delete;
+		~Scanner();				// deconstructor, releases input buffer
 		Token scanToken();		// scans and returns arbitrary Token
 		Token scanInstruction();// scans and returns an instruction as Token
 		Token scanRegister();	// scans and returns a register as Token
 		Token scanConstant();	// scans and returns an int as Token
 		Token scanArrow();		// scans and returns assignment arrow as Token
 		Token scanComma();		// scans and returns a comma as Token
+		size_t size() const;	// returns length of input in bytes
+		const char* data() const;	// returns start of input, unless streaming
+		bool skipLine();		// drops rest of line after an error
+		long tokens;			// number of Tokens scanned
 	private:
 		string infile;			// name of input file
-		ifstream input;			// input file stream
+		const char* buf;		// start of input buffer
+		const char* cur;		// next unread character
+		const char* end;		// one past last character of input
+		size_t mapped;			// length of mmapped region (0 if not mapped)
+		string contents;		// holds input that could not be mmapped
+		int fd;					// input being streamed, or INVALID
+		bool borrowed;			// buffer belongs to the caller
 		bool print;				// indicates whether -t option was passed
 		int ln;					// current line number
 		int pos;				// index of character on current line
-		int get();				// extension of std::ifstream::get()
-		istream& get(char& c);	// extension of std::ifstream::get(char& c)
+		bool resync;			// skipLine() ran; next line may start anywhere
+		void mapInput();		// maps (or reads) infile into buffer
+		bool refill();			// reads the next chunk when streaming
+		int peek();				// returns next character without consuming
+		int get();				// consumes next character, counting lines
+		bool accept(char c);	// consumes next character if it is c
 		bool ensureWS();		// returns bool indicating presences of WS
 		bool ensureNL();		// returns bool indicating presence of new line
 		void removeWS();		// scans and discards whitespace
 		void removeComment();	// scans and discards a comment
-		void error(string msg);	// prints explicit error message and terminates
+		int matchOpcode();		// consumes a whole opcode, or returns INVALID
+		[[noreturn]] void error(string msg);	// throws a Diagnostic
 		int scanNumber();		// scans and returns an int
 		Token scanAlpha();		// scanToken() helper, called on alpha characters
 };
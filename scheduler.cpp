@@ -8,265 +8,1356 @@
  *                               *
  * * * * * * * * * * * * * * * * */
 
-#include "scheduler.h"
+#include "allocator.h"
+#include "alias.h"
+#include "cache.h"
+#include "simulator.h"
 
 
+// name of each Phase, as reported by timings
+const char* const phaseNames[] = {
+	"parse", "assignVRs", "buildDepGraph", "reduceGraph",
+	"computeWeights", "computeSlack", "listSchedule", "allocate",
+	"simulate", "print"
+};
 
-// Node constructor.
-Scheduler::Node::Node(Instruction in) :i{in}, weight{0} {}
+
+// name of each Heuristic, as given to -p
+const char* const heuristicNames[] = {
+	"weight", "fanout", "pressure", "backward"
+};
+
+
+// Machine constructor.
+//
+// takes number of functional units. with two or more
+// units, load and store issue only on unit 0 and mult
+// only on unit 1; everything else may use any unit.
+Machine::Machine(int w) :width{w} {
+	unsigned all = (1u << width) - 1;
+	for (int op = load; op <= nop; ++op)
+		units[op] = all;
+	if (width >= 2) {
+		units[load] = units[store] = 1u << 0;
+		units[mult] = 1u << 1;
+	}
+}
+
+
+// returns the free unit an op of Opcode op should take:
+// of those it may use, the one the fewest ready ops
+// (queued[o] of each Opcode o) could also use, so a
+// unit is not taken from an op that has no other while
+// one that suits nobody else sits idle. ties go to the
+// lowest numbered unit.
+int Machine::unitFor(int op, unsigned freeUnits,
+		const size_t queued[]) const {
+	int best = INVALID;
+	size_t fewest = 0;
+	for (int u = 0; u < width; ++u) {
+		if (!(units[op] & freeUnits & (1u << u)))
+			continue;
+		size_t wanting = 0;
+		for (int o = load; o <= nop; ++o)
+			if (units[o] >> u & 1)
+				wanting += queued[o];
+		if (best == INVALID || wanting < fewest) {
+			best = u;
+			fewest = wanting;
+		}
+	}
+	return best;
+}
+
+
+
+// Options constructor.
+// defaults to printing the dependency graph.
+Options::Options() :schedule{false}, stats{false}, registers{0},
+		cache{false}, disambiguate{false}, reduce{false}, simulate{false},
+		heuristics{WeightHeuristic}, graphThreads{1}, recover{false},
+		slack{false} {}
+
+
+// every source of a cycle, plus the register holding
+// spill addresses, must fit at once.
+int Options::minRegisters() const {
+	return (schedule ? 2 * machine.width : 2) + 1;
+}
+
+
+// returns a message for each field out of range: the
+// machine's width and unit masks, registers, graphThreads
+// and (when scheduling) heuristics.
+vector<string> Options::problems() const {
+	vector<string> found;
+	if (machine.width < 1 || machine.width > MAX_UNITS)
+		found.push_back("machine width " + std::to_string(machine.width)
+			+ " is not between 1 and " + std::to_string(MAX_UNITS));
+	else
+		for (int op = load; op <= nop; ++op)
+			if (machine.units[op] == 0 || machine.units[op] >> machine.width)
+				found.push_back(string("units for ") + opcodeNames[op]
+					+ " must name at least one unit, all below "
+					+ std::to_string(machine.width));
+	if (registers != 0 && registers < minRegisters())
+		found.push_back("registers must be 0 or at least "
+			+ std::to_string(minRegisters()));
+	if (graphThreads < 1)
+		found.push_back("graphThreads must be at least 1");
+	if (schedule && heuristics.empty())
+		found.push_back("no heuristics to schedule with");
+	for (Heuristic h : heuristics)
+		if (h < 0 || h >= NumHeuristics)
+			found.push_back("unknown heuristic " + std::to_string(h));
+	return found;
+}
 
 
 // Scheduler constructor.
 //
-// Sets Instruction labels, creates Nodes,
-// assigns virtual registers, then calls member
-// functions to create dependency graph and
-// calculate latency-weighted distances to roots.
-Scheduler::Scheduler(string infile, bool sp)
-			:intRep{Parser{infile, sp}.intRep} {
-	int n = 0;
+// Loads the renamed IR from cache if opts asks for one
+// and it still matches infile. Otherwise parses infile
+// (see takeIR) and, if it had no errors, saves the result
+// to cache, keyed by the bytes the Parser read. Then
+// builds the graph (see analyze).
+Scheduler::Scheduler(string infile, bool sp, const Options& opts)
+		:Scheduler{opts} {
+	Clock::time_point start = Clock::now();
+
+	string cache = opts.cache ? cachePath(infile, opts.cacheDir) : "";
+	uint64_t size, hash;
+	bool hashed = opts.cache && hashSource(infile, size, hash);
+	if (hashed && loadIR(cache, size, hash)) {
+		cached = true;
+		lap(ParsePhase, start);
+	} else {
+		Parser parser {infile, sp, false, opts.recover};
+		takeIR(parser, start);
+		if (hashed && diagnostics.empty())
+			saveIR(cache, parser.size(),
+				checksum(parser.data(), parser.size()));
+		start = Clock::now();
+	}
+
+	analyze(opts, start);
+}
+
+
+// Scheduler buffer constructor.
+//
+// parses the ILOC in text[0, length) where it lies,
+// reporting errors under name, then builds the graph as
+// the file constructor does. nothing is cached.
+Scheduler::Scheduler(const char* text, size_t length, const string& name,
+		const Options& opts) :Scheduler{opts} {
+	Clock::time_point start = Clock::now();
+	Parser parser {text, length, name, false, opts.recover};
+	takeIR(parser, start);
+	start = Clock::now();
+	analyze(opts, start);
+}
+
+
+// sets every counter to zero; the public constructors
+// fill in the rest.
+Scheduler::Scheduler(const Options& opts)
+		:width{0}, heuristic{WeightHeuristic}, raced{0}, planCycles{},
+		planSeconds{}, seconds{}, instructions{0}, cached{false}, tokens{0},
+		registerEdges{0}, serialEdges{0}, readyPushes{0}, graphThreads{1},
+		registers{0}, spillStores{0}, spillLoads{0}, remats{0},
+		allocCycles{0}, disambiguated{opts.disambiguate}, baselineEdges{0},
+		baselinePath{0}, reduced{opts.reduce}, reducedEdges{0},
+		slackFound{false}, simulated{false}, simCycles{0}, simStalls{0},
+		simOk{true} {}
+
+
+// takes the Parser's IR and diagnostics without copying
+// them, drops its nops in place to leave the Nodes
+// (labelled by their index), and assigns virtual
+// registers, timing each phase from start.
+void Scheduler::takeIR(Parser& parser, Clock::time_point& start) {
 	int highReg = -1;
 
-	for (Instruction in : intRep) {
-		// set Instruction labels and create to Nodes
-		if (in.op != nop) {
-			in.label = n++;
-			nodes.push_back(new Node{in});
-		}
+	nodes = std::move(parser.intRep);
+	diagnostics = std::move(parser.diagnostics);
+	instructions = nodes.size();
+	tokens = parser.tokens();
+
+	// create Nodes
+	nodes.erase(remove_if(nodes.begin(), nodes.end(),
+		[](const Instruction& in) { return in.op == nop; }), nodes.end());
+	for (const Instruction& in : nodes) {
 		// get highest number of sr so
 		// sr2vr is of adequate size
-		if (in.src1.isReg && in.src1.sr > highReg)
-			highReg = in.src1.sr;
-		if (in.src2.isReg && in.src2.sr > highReg)
-			highReg = in.src2.sr;
-		if (in.dest.isReg && in.dest.sr > highReg)
-			highReg = in.dest.sr;
+		for (int o = Src1; o < NumOperands; ++o)
+			if (in.isReg(o) && in.operand[o] > highReg)
+				highReg = in.operand[o];
 	}
+	lap(ParsePhase, start);
 
 	// assign unique VR to each value
 	assignVRs(highReg + 1);
+	lap(RenamePhase, start);
+}
+
+
+// creates the dependency graph (telling memory addresses
+// apart if opts.disambiguate is set, or on
+// opts.graphThreads threads if not), reduces it if
+// opts.reduce is set, and calculates latency-weighted
+// distances to roots (and with opts.slack, start windows
+// and a critical path), timing each phase from start.
+void Scheduler::analyze(const Options& opts, Clock::time_point& start) {
 
 	// create edges between nodes
-	buildDepGraph();
+	if (opts.disambiguate) {
+		Disambiguator alias {*this};
+		buildDepGraph(&alias);
+		baselineEdges = alias.baselineEdges;
+		baselinePath = alias.baselinePath;
+	} else if (opts.graphThreads > 1 && !nodes.empty()) {
+		graphThreads = opts.graphThreads;
+		buildDepGraph(graphThreads);
+	} else
+		buildDepGraph();
+	lap(GraphPhase, start);
+
+	// drop edges that other paths imply
+	if (opts.reduce) {
+		reduceGraph();
+		lap(ReducePhase, start);
+	}
 
 	// compute latency-weighted distances to roots
 	computeWeights();
+	lap(WeightPhase, start);
+
+	// find how far each Node may move
+	if (opts.slack) {
+		computeSlack();
+		lap(SlackPhase, start);
+	}
 
 }
 
 
-// Scheduler destructor.
+// builds dependency graph in a single pass over nodes.
 //
-// Deletes all dynamically allocated Nodes.
-Scheduler::~Scheduler() {
-	for (Node* n : nodes)
-		delete n;
-}
+// every virtual register has exactly one definition, so a
+// table from VR to defining Node yields register edges.
+// serialization edges only ever reach back to the most
+// recent store, the most recent output, and (for stores)
+// every earlier load, so those are tracked as the walk
+// proceeds rather than rediscovered by comparing pairs.
+//
+// given a Disambiguator, serialization edges come from it
+// instead, joining only memory operations that may alias.
+//
+// children are appended Node by Node, so childStart and
+// children come out in order; parents are then filled in
+// by counting each Node's in-degree.
+void Scheduler::buildDepGraph(Disambiguator* alias) {
 
+	int size = nodes.size();
+	vector<int> def (numVRs, INVALID);	// VR -> defining Node
+	vector<int> loads;					// every load seen so far
+	int lastStore = INVALID;
+	int lastOutput = INVALID;
+	vector<int> deps;					// children of current Node
+	vector<int> merged;					// deps merged with loads
 
-// builds dependency graph.
-void Scheduler::buildDepGraph() {
+	childStart.assign(1, 0);
+	childStart.reserve(size + 1);
+	children.clear();
 
-	Node* snapper;
-	Node* arctic;
-	bool addEdge;
-	bool recentStore;
-	bool recentOutput;
+	for (int n = 0; n < size; ++n) {
 
-	// 'turtle' for slower outer iterator
-	for (auto turtle = nodes.begin();  turtle != nodes.end(); ++turtle) {
+		const Instruction& in = nodes[n];
+		const int* v = &vr[NumOperands * n];
+		deps.clear();
 
-		snapper = *turtle;
-		recentStore = false;
-		recentOutput = false;
+		// Register Edges
+		if (in.isReg(Src1) && def[v[Src1]] != INVALID)
+			deps.push_back(def[v[Src1]]);
+		if (in.isReg(Src2) && def[v[Src2]] != INVALID)
+			deps.push_back(def[v[Src2]]);
+		int regDeps = deps.size();
+		if (regDeps == 2 && deps[0] == deps[1])
+			regDeps = 1;
 
-		// 'fox' for quicker inner iterator
-		for (auto fox = turtle + 1; fox != nodes.end(); ++fox) {
+		// Serialization Edges
+		if (alias)
+			alias->serialize(n, deps);
+		else switch (in.op) {
+			case load:
+				if (lastStore != INVALID)
+					deps.push_back(lastStore);
+				break;
+			case store:
+			case output:
+				if (lastStore != INVALID)
+					deps.push_back(lastStore);
+				if (lastOutput != INVALID)
+					deps.push_back(lastOutput);
+				break;
+			default:
+				break;
+		}
 
-			arctic = *fox;
-			addEdge = false;
+		sort(deps.begin(), deps.end());
+		deps.erase(unique(deps.begin(), deps.end()), deps.end());
 
-			// determine whether to add Serialization Edge
-			switch (snapper->i.op) {
+		// stores also depend on every earlier load
+		vector<int>* edges = &deps;
+		if (in.op == store && !alias && !loads.empty()) {
+			merged.clear();
+			set_union(deps.begin(), deps.end(), loads.begin(), loads.end(),
+				back_inserter(merged));
+			edges = &merged;
+		}
 
-				case load:
-					if (arctic->i.op == store)
-						addEdge = true;
-					break;
+		// add the edges!
+		children.insert(children.end(), edges->begin(), edges->end());
+		childStart.push_back(children.size());
+		registerEdges += regDeps;
+		serialEdges += edges->size() - regDeps;
 
-				case output:
-					if (!recentOutput
-					&& (arctic->i.op == output
-					|| arctic->i.op == store))
-						addEdge = true;
-					break;
+		// record what this Node provides to later Nodes
+		if (in.isReg(Dest))
+			def[v[Dest]] = n;
+		if (!alias) switch (in.op) {
+			case load:
+				loads.push_back(n);
+				break;
+			case store:
+				lastStore = n;
+				break;
+			case output:
+				lastOutput = n;
+				break;
+			default:
+				break;
+		}
+
+	}
 
-				case store:
-					if (!recentStore
-					&& (arctic->i.op == load
-					|| arctic->i.op == store
-					|| arctic->i.op == output))
-						addEdge = true;
-					break;
+	buildParents();
 
-				default:
-					break;
+}
+
+
+// builds the same dependency graph as buildDepGraph(),
+// splitting nodes into one chunk per thread.
+//
+// every VR has one definition, read only by later Nodes,
+// so the table from VR to defining Node can be filled by
+// every chunk at once. the memory state each chunk starts
+// from (the last store and output before it, and how many
+// loads precede it) follows from the chunks before it;
+// the loads themselves are gathered in label order, so
+// the loads before any Node are a prefix of them. each
+// chunk then finds its own edges, and copies them into
+// place once the chunks before it have been counted.
+// no two threads ever write the same element.
+void Scheduler::buildDepGraph(int threads) {
+
+	int size = nodes.size();
+	threads = min(threads, size);
+	vector<int> def (numVRs, INVALID);	// VR -> defining Node
+	vector<int> lastStore (threads + 1, INVALID);	// before each chunk
+	vector<int> lastOutput (threads + 1, INVALID);
+	vector<vector<int>> chunkLoads (threads);
+	vector<int> loadStart (threads + 1, 0);
+	vector<int> loads;					// every load, in order
+	vector<vector<int>> chunkEdges (threads);
+	vector<long> regEdges (threads, 0), serEdges (threads, 0);
+	vector<int> edgeStart (threads + 1, 0);
+
+	childStart.assign(size + 1, 0);
+	auto first = [size, threads](int k) { return (int)((long)size * k / threads); };
+	// what a worker throws (running out of memory, say) is
+	// rethrown here once every worker is done. a chunk no
+	// thread can be started for is run here.
+	vector<exception_ptr> failed (threads);
+	auto inParallel = [threads, &failed](std::function<void(int)> work) {
+		vector<thread> workers;
+		for (int k = 0; k < threads; ++k) {
+			auto guarded = [&work, &failed, k] {
+				try {
+					work(k);
+				} catch (...) {
+					failed[k] = std::current_exception();
+				}
+			};
+			try {
+				workers.emplace_back(guarded);
+			} catch (const std::system_error&) {
+				guarded();
+			}
+		}
+		for (thread& w : workers)
+			w.join();
+		for (exception_ptr& f : failed)
+			if (f)
+				std::rethrow_exception(f);
+	};
+
+	// definitions, and what each chunk leaves behind
+	inParallel([&](int k) {
+		for (int n = first(k); n < first(k + 1); ++n) {
+			const Instruction& in = nodes[n];
+			if (in.isReg(Dest))
+				def[vr[NumOperands * n + Dest]] = n;
+			if (in.op == load)
+				chunkLoads[k].push_back(n);
+			else if (in.op == store)
+				lastStore[k + 1] = n;
+			else if (in.op == output)
+				lastOutput[k + 1] = n;
+		}
+	});
+	for (int k = 0; k < threads; ++k) {
+		if (lastStore[k + 1] == INVALID)
+			lastStore[k + 1] = lastStore[k];
+		if (lastOutput[k + 1] == INVALID)
+			lastOutput[k + 1] = lastOutput[k];
+		loadStart[k + 1] = loadStart[k] + chunkLoads[k].size();
+		loads.insert(loads.end(), chunkLoads[k].begin(), chunkLoads[k].end());
+	}
+
+	// edges of each chunk, as in buildDepGraph()
+	inParallel([&](int k) {
+		int storeBefore = lastStore[k], outputBefore = lastOutput[k];
+		int loadsBefore = loadStart[k];
+		vector<int> deps, merged;
+		vector<int>& edges = chunkEdges[k];
+		for (int n = first(k); n < first(k + 1); ++n) {
+
+			const Instruction& in = nodes[n];
+			const int* v = &vr[NumOperands * n];
+			deps.clear();
+
+			if (in.isReg(Src1) && def[v[Src1]] != INVALID)
+				deps.push_back(def[v[Src1]]);
+			if (in.isReg(Src2) && def[v[Src2]] != INVALID)
+				deps.push_back(def[v[Src2]]);
+			int regDeps = deps.size();
+			if (regDeps == 2 && deps[0] == deps[1])
+				regDeps = 1;
+
+			if (in.op == load && storeBefore != INVALID)
+				deps.push_back(storeBefore);
+			else if (in.op == store || in.op == output) {
+				if (storeBefore != INVALID)
+					deps.push_back(storeBefore);
+				if (outputBefore != INVALID)
+					deps.push_back(outputBefore);
 			}
 
-			// track what's beyond the turtle;
-			// only want most recent of these for edges.
-			if (arctic->i.op == store)
-				recentStore = true;
-			if (arctic->i.op == output)
-				recentOutput = true;
-
-			// determine whether to add Register Edge
-			if ((arctic->i.src1.isReg && arctic->i.src1.vr == snapper->i.dest.vr)
-			|| (arctic->i.src2.isReg && arctic->i.src2.vr == snapper->i.dest.vr))
-				addEdge = true;
-
-			// add the edges!
-			if (addEdge) {
-				arctic->children.push_back(snapper);
-				snapper->parents.push_back(arctic);
+			sort(deps.begin(), deps.end());
+			deps.erase(unique(deps.begin(), deps.end()), deps.end());
+
+			vector<int>* found = &deps;
+			if (in.op == store && loadsBefore) {
+				merged.clear();
+				set_union(deps.begin(), deps.end(),
+					loads.begin(), loads.begin() + loadsBefore, back_inserter(merged));
+				found = &merged;
 			}
 
+			edges.insert(edges.end(), found->begin(), found->end());
+			childStart[n + 1] = found->size();
+			regEdges[k] += regDeps;
+			serEdges[k] += found->size() - regDeps;
+
+			if (in.op == load)
+				++loadsBefore;
+			else if (in.op == store)
+				storeBefore = n;
+			else if (in.op == output)
+				outputBefore = n;
 		}
+	});
+
+	// place each chunk's edges after those before it
+	for (int k = 0; k < threads; ++k) {
+		edgeStart[k + 1] = edgeStart[k] + chunkEdges[k].size();
+		registerEdges += regEdges[k];
+		serialEdges += serEdges[k];
 	}
+	children.resize(edgeStart[threads]);
+	inParallel([&](int k) {
+		int at = edgeStart[k];
+		for (int n = first(k); n < first(k + 1); ++n) {
+			at += childStart[n + 1];
+			childStart[n + 1] = at;
+		}
+		std::copy(chunkEdges[k].begin(), chunkEdges[k].end(),
+			children.begin() + edgeStart[k]);
+		vector<int>().swap(chunkEdges[k]);
+	});
+
+	buildParents();
+
+}
+
+
+// fills parentStart and parents from the children:
+// counts each Node's parents, then places them.
+// walking Nodes in order keeps each parent list sorted.
+void Scheduler::buildParents() {
+
+	int size = nodes.size();
+	parentStart.assign(size + 1, 0);
+	for (int c : children)
+		parentStart[c + 1]++;
+	for (int n = 0; n < size; ++n)
+		parentStart[n + 1] += parentStart[n];
+
+	parents.resize(children.size());
+	vector<int> next (parentStart.begin(), parentStart.end() - 1);
+	for (int n = 0; n < size; ++n)
+		for (int e = childStart[n]; e < childStart[n + 1]; ++e)
+			parents[next[children[e]]++] = n;
+
+}
+
+
+// transitive reduction: removes every edge n -> c for
+// which some other child of n already reaches c.
+//
+// paths only ever run from higher labels to lower ones,
+// so c can only be reached through a child of n above
+// c. the descendants of each Node are kept as bitsets,
+// one tile of REDUCE_TILE labels at a time: for the tile
+// [lo, hi), only Nodes from lo up to the last parent of
+// any Node in the tile can reach it, so only those rows
+// are computed. each Node's children are visited from
+// the highest down, so by the time c is reached its bit
+// is set exactly when the edge n -> c is implied.
+//
+// tiles are taken from the highest down as well, so the
+// edges above the current tile are already decided, and
+// only the kept ones need to be merged into a row: an
+// implied child reaches nothing a kept one does not.
+// kept children are packed at the end of each Node's
+// range of children as they are found.
+//
+// dropping an implied edge changes no weight and no
+// schedule, since the path through the other child is
+// at least as long. the fanout heuristic counts parents,
+// so their number before any are dropped is kept for it.
+void Scheduler::reduceGraph() {
+
+	const int words = REDUCE_TILE / 64;
+	int size = nodes.size();
+	fanout.resize(size);
+	for (int n = 0; n < size; ++n)
+		fanout[n] = parentStart[n + 1] - parentStart[n];
+	vector<int> unseen (childStart.begin() + 1, childStart.end());
+	vector<int> kept (childStart.begin() + 1, childStart.end());
+	vector<uint64_t> reach;		// descendants in tile, words per row
+
+	for (int lo = (size - 1) / REDUCE_TILE * REDUCE_TILE; lo >= 0;
+			lo -= REDUCE_TILE) {
+		int hi = min(size, lo + REDUCE_TILE);
+		int top = hi - 1;		// last Node that can reach the tile
+		for (int c = lo; c < hi; ++c)
+			if (parentStart[c + 1] > parentStart[c])
+				top = max(top, parents[parentStart[c + 1] - 1]);
+
+		reach.assign((size_t)(top - lo + 1) * words, 0);
+		for (int n = lo; n <= top; ++n) {
+			uint64_t* row = &reach[(size_t)(n - lo) * words];
+
+			// everything reachable through kept children above
+			for (int e = kept[n]; e < childStart[n + 1]; ++e) {
+				const uint64_t* from = &reach[(size_t)(children[e] - lo) * words];
+				for (int w = 0; w < words; ++w)
+					row[w] |= from[w];
+			}
+
+			// children in the tile, highest first
+			while (unseen[n] > childStart[n] && children[unseen[n] - 1] >= lo) {
+				int c = children[--unseen[n]];
+				int b = c - lo;
+				if (row[b / 64] >> (b % 64) & 1)
+					continue;
+				const uint64_t* from = &reach[(size_t)b * words];
+				for (int w = 0; w < words; ++w)
+					row[w] |= from[w];
+				row[b / 64] |= 1ull << (b % 64);
+				children[--kept[n]] = c;
+			}
+		}
+	}
+
+	// close the gaps, then rebuild the parents
+	int edges = 0;
+	for (int n = 0; n < size; ++n) {
+		int first = kept[n], last = childStart[n + 1];
+		childStart[n] = edges;
+		for (int e = first; e < last; ++e)
+			children[edges++] = children[e];
+	}
+	childStart[size] = edges;
+	children.resize(edges);
+	reducedEdges = edges;
+
+	buildParents();
 
 }
 
 
 // computes latencty-weighted distance to
-// a root for every node using a worklist.
+// a root for every node in a single sweep.
+//
+// every edge runs from a later Node to an earlier one,
+// so label order is a topological order of the graph.
+// walking nodes from last to first visits each Node
+// after all of its parents, touching every Node and
+// edge exactly once.
 void Scheduler::computeWeights() {
 
-	queue<Node*> worklist;
+	weights.assign(nodes.size(), 0);
+
+	for (int n = nodes.size() - 1; n >= 0; --n) {
+
+		int heavyParent = 0;	// max parent weight
+		for (int e = parentStart[n]; e < parentStart[n + 1]; ++e)
+			if (weights[parents[e]] > heavyParent)
+				heavyParent = weights[parents[e]];
+
+		weights[n] = heavyParent + latency((Opcode)nodes[n].op);
 
-	// find roots - put them on worklist
-	for (Node* n : nodes) {
-		if (n->parents.empty())
-			worklist.push(n);
 	}
 
-	// perform work until worklist is empty
-	Node* curr;
-	int latency;
-	while (!worklist.empty()) {
+}
 
-		curr = worklist.front();
-		worklist.pop();
 
-		// properly set the latency
-		switch (curr->i.op) {
-			case load:
-			case store:
-				latency = 3;
-				break;
-			case mult:
-				latency = 2;
+// computes the earliest and latest cycle each Node could
+// issue in, and a critical path, in two sweeps.
+//
+// in label order every child comes before its parents,
+// so one forward sweep finds the earliest start: the
+// latest cycle a child's result lands in. a Node's weight
+// already counts the cycles from its issue to the end of
+// the longest path, so its latest start is that many
+// cycles before the end. slack is the difference, and
+// a Node with none lies on a longest path. starting from
+// the lowest labelled Node of greatest weight, the path
+// is followed through parents whose weight is exactly
+// what remains, so each edge is looked at no more than
+// once.
+void Scheduler::computeSlack() {
+
+	int size = nodes.size();
+	int length = 0;		// cycles in the longest path
+	earliestStart.assign(size, 1);
+	latestStart.assign(size, 1);
+	criticalPath.clear();
+	slackFound = true;
+
+	for (int n = 0; n < size; ++n) {
+		for (int e = childStart[n]; e < childStart[n + 1]; ++e) {
+			int c = children[e];
+			earliestStart[n] = max(earliestStart[n],
+				earliestStart[c] + latency((Opcode)nodes[c].op));
+		}
+		length = max(length, weights[n]);
+	}
+
+	int n = INVALID;
+	for (int m = size - 1; m >= 0; --m) {
+		latestStart[m] = length + 1 - weights[m];
+		if (weights[m] == length)
+			n = m;
+	}
+
+	while (n != INVALID) {
+		criticalPath.push_back(n);
+		int rest = weights[n] - latency((Opcode)nodes[n].op);
+		int next = INVALID;
+		for (int e = parentStart[n]; e < parentStart[n + 1]; ++e)
+			if (weights[parents[e]] == rest) {
+				next = parents[e];
 				break;
-			default:
-				latency = 1;
+			}
+		n = next;
+	}
+
+}
+
+
+// cycle-by-cycle list scheduler.
+//
+// makes a Plan with every Heuristic in heuristics, each
+// on its own thread when there are several, and keeps
+// the one whose last result lands first (ties go to the
+// one earliest in heuristics). Plans only read the graph, so
+// the threads share it as it is, and the wall time is
+// that of the slowest Heuristic rather than their sum.
+void Scheduler::listSchedule(const Machine& m,
+		const vector<Heuristic>& heuristics) {
+
+	Clock::time_point start = Clock::now();
+	vector<Plan> plans (NumHeuristics);
+	vector<exception_ptr> failed (NumHeuristics);
+	vector<thread> workers;
+
+	raced = 0;
+	for (int h = 0; h < NumHeuristics; ++h) {
+		planCycles[h] = INVALID;
+		planSeconds[h] = 0;
+	}
+	for (Heuristic h : heuristics) {
+		raced |= 1u << h;
+		auto make = [this, &m, &plans, h] {
+			Clock::time_point begin = Clock::now();
+			plans[h] = plan(m, h);
+			planSeconds[h] =
+				std::chrono::duration<double>(Clock::now() - begin).count();
+		};
+		auto guarded = [make, &failed, h] {
+			try {
+				make();
+			} catch (...) {
+				failed[h] = std::current_exception();
+			}
+		};
+		if (heuristics.size() == 1)
+			make();
+		else try {
+			workers.emplace_back(guarded);
+		} catch (const std::system_error&) {
+			// no thread to spare; make it here
+			guarded();
+		}
+	}
+	for (thread& w : workers)
+		w.join();
+	// what a thread threw (running out of memory, say)
+	// is thrown on to the caller
+	for (exception_ptr& f : failed)
+		if (f)
+			std::rethrow_exception(f);
+
+	int best = INVALID;
+	for (Heuristic h : heuristics) {
+		planCycles[h] = plans[h].cycles;
+		if (best == INVALID || plans[h].cycles < plans[best].cycles)
+			best = h;
+	}
+
+	heuristic = (Heuristic)best;
+	width = m.width;
+	issue = std::move(plans[best].issue);
+	slots = std::move(plans[best].slots);
+	readyPushes = plans[best].pushes;
+
+	lap(SchedulePhase, start);
+}
+
+
+// list schedules the graph under Heuristic h.
+//
+// a Node becomes ready once every Node it depends on has
+// completed, and each cycle the units are filled with the
+// ready Nodes of highest priority (ties go to the earlier
+// label). ready Nodes are kept in one priority queue per
+// Opcode, so a Node that cannot issue because its units
+// are busy never has to be popped and pushed back; each
+// Node passes through the queues once, keeping this
+// O(n log n).
+Scheduler::Plan Scheduler::plan(const Machine& m, Heuristic h) const {
+
+	if (h == BackwardHeuristic)
+		return planBackward(m);
+
+	typedef pair<int, int> Entry;
+	int size = nodes.size();
+	vector<int> key;				// priority of each Node
+	vector<int> waiting (size);		// children not yet issued
+	vector<int> earliest (size, 1);	// first cycle operands are ready
+	priority_queue<Entry> ready[nop + 1];	// (key, -label)
+	priority_queue<Entry, vector<Entry>, greater<Entry>> pending; // (cycle, label)
+	Plan p {vector<int>(size, INVALID), vector<int>(), 0, 0};
+
+	priorities(h, key);
+	for (int n = 0; n < size; ++n) {
+		waiting[n] = childStart[n + 1] - childStart[n];
+		if (waiting[n] == 0)
+			pending.push(Entry {earliest[n], n});
+	}
+
+	int done = 0;
+	for (int cycle = 1; done < size; ++cycle) {
+
+		// move Nodes whose operands are now available to ready
+		while (!pending.empty() && pending.top().first <= cycle) {
+			int n = pending.top().second;
+			pending.pop();
+			ready[nodes[n].op].push(Entry {key[n], -n});
+			++p.pushes;
+		}
+
+		unsigned freeUnits = (1u << m.width) - 1;
+		size_t bundle = p.slots.size();
+		p.slots.resize(bundle + m.width, INVALID);
+
+		while (freeUnits) {
+			// highest priority ready Node that has a free unit
+			int best = INVALID;
+			for (int op = load; op <= nop; ++op)
+				if (!ready[op].empty() && (m.units[op] & freeUnits)
+				&& (best == INVALID || ready[best].top() < ready[op].top()))
+					best = op;
+			if (best == INVALID)
 				break;
+
+			int n = -ready[best].top().second;
+			ready[best].pop();
+
+			// the free unit it may use that others need least
+			size_t queued[nop + 1];
+			for (int o = load; o <= nop; ++o)
+				queued[o] = ready[o].size();
+			int u = m.unitFor(best, freeUnits, queued);
+			freeUnits &= ~(1u << u);
+			p.slots[bundle + u] = n;
+			p.issue[n] = cycle;
+			++done;
+
+			// parents may start once this Node completes
+			int finish = cycle + latency((Opcode)nodes[n].op);
+			p.cycles = max(p.cycles, finish - 1);
+			for (int e = parentStart[n]; e < parentStart[n + 1]; ++e) {
+				int par = parents[e];
+				earliest[par] = max(earliest[par], finish);
+				if (--waiting[par] == 0)
+					pending.push(Entry {earliest[par], par});
+			}
 		}
 
-		bool putBack = false;	// flag
-		int heavyParent = 0;	// max parent weight
+	}
+
+	return p;
+}
+
+
+// list schedules the reversed graph, from the last cycle
+// back to the first.
+//
+// a Node becomes ready once every Node depending on it
+// has been placed far enough after it for its result to
+// land, and the one with the longest latency-weighted
+// path below it goes first (ties go to the later label).
+// reverse cycle r is then forward cycle R + 1 - r, where
+// R is the last reverse cycle; reverse cycles before the
+// first placement would only idle after the block ends.
+Scheduler::Plan Scheduler::planBackward(const Machine& m) const {
 
-		// if not a root
-		if (!curr->parents.empty()) {
-			for (Node* n : curr->parents) {
-				if (n->weight == 0) {
-					putBack = true;
-					worklist.push(n);
-				} else if (n->weight > heavyParent)
-					heavyParent = n->weight;
+	typedef pair<int, int> Entry;
+	int size = nodes.size();
+	vector<int> depth (size, 0);	// latency-weighted distance to a leaf
+	vector<int> waiting (size);		// parents not yet placed
+	vector<int> earliest (size);	// first reverse cycle it may go in
+	vector<int> place (size);		// reverse cycle it went in
+	vector<int> reversed;			// width slots per reverse cycle
+	priority_queue<Entry> ready[nop + 1];	// (depth, label)
+	priority_queue<Entry, vector<Entry>, greater<Entry>> pending; // (cycle, label)
+	Plan p {vector<int>(size), vector<int>(), 0, 0};
+
+	// children come before their parents
+	for (int n = 0; n < size; ++n)
+		for (int e = childStart[n]; e < childStart[n + 1]; ++e) {
+			int c = children[e];
+			depth[n] = max(depth[n], depth[c] + latency((Opcode)nodes[c].op));
+		}
+
+	// a result must land by the last cycle
+	for (int n = 0; n < size; ++n) {
+		waiting[n] = parentStart[n + 1] - parentStart[n];
+		earliest[n] = latency((Opcode)nodes[n].op);
+		if (waiting[n] == 0)
+			pending.push(Entry {earliest[n], n});
+	}
+
+	int done = 0, first = INVALID, cycle = 1;
+	for (; done < size; ++cycle) {
+
+		while (!pending.empty() && pending.top().first <= cycle) {
+			int n = pending.top().second;
+			pending.pop();
+			ready[nodes[n].op].push(Entry {depth[n], n});
+			++p.pushes;
+		}
+
+		unsigned freeUnits = (1u << m.width) - 1;
+		size_t bundle = reversed.size();
+		reversed.resize(bundle + m.width, INVALID);
+
+		while (freeUnits) {
+			int best = INVALID;
+			for (int op = load; op <= nop; ++op)
+				if (!ready[op].empty() && (m.units[op] & freeUnits)
+				&& (best == INVALID || ready[best].top() < ready[op].top()))
+					best = op;
+			if (best == INVALID)
+				break;
+
+			int n = ready[best].top().second;
+			ready[best].pop();
+
+			size_t queued[nop + 1];
+			for (int o = load; o <= nop; ++o)
+				queued[o] = ready[o].size();
+			int u = m.unitFor(best, freeUnits, queued);
+			freeUnits &= ~(1u << u);
+			reversed[bundle + u] = n;
+			place[n] = cycle;
+			if (first == INVALID)
+				first = cycle;
+			++done;
+
+			// children must issue early enough to feed it
+			for (int e = childStart[n]; e < childStart[n + 1]; ++e) {
+				int c = children[e];
+				earliest[c] = max(earliest[c], cycle + latency((Opcode)nodes[c].op));
+				if (--waiting[c] == 0)
+					pending.push(Entry {earliest[c], c});
 			}
 		}
 
-		if (putBack)
-			worklist.push(curr);
-		else {
-			curr->weight = heavyParent + latency;
-			for (Node* n : curr->children)
-				worklist.push(n);
+	}
+
+	// turn it around
+	int last = cycle - 1;
+	for (int n = 0; n < size; ++n) {
+		p.issue[n] = last + 1 - place[n];
+		p.cycles = max(p.cycles, p.issue[n] + latency((Opcode)nodes[n].op) - 1);
+	}
+	for (int r = last; size && r >= first; --r)
+		p.slots.insert(p.slots.end(), reversed.begin() + (size_t)(r - 1) * m.width,
+			reversed.begin() + (size_t)r * m.width);
+
+	return p;
+}
+
+
+// sets key to the priority of each Node under forward
+// Heuristic h: its weight, or its rank by weight and then
+// the Heuristic's tie-breaker.
+//
+// registers freed counts the distinct VRs a Node reads
+// last (in label order), less one if it defines a VR.
+void Scheduler::priorities(Heuristic h, vector<int>& key) const {
+
+	if (h == WeightHeuristic) {
+		key = weights;
+		return;
+	}
+
+	int size = nodes.size();
+	vector<int> tie (size);
+	if (h == FanoutHeuristic)
+		for (int n = 0; n < size; ++n)
+			tie[n] = reduced ? fanout[n] : parentStart[n + 1] - parentStart[n];
+	else {
+		vector<int> lastRead (numVRs, INVALID);
+		for (int n = 0; n < size; ++n)
+			for (int o = Src1; o <= Src2; ++o)
+				if (nodes[n].isReg(o))
+					lastRead[vr[NumOperands * n + o]] = n;
+		for (int n = 0; n < size; ++n) {
+			const int* v = &vr[NumOperands * n];
+			tie[n] = nodes[n].isReg(Dest) ? -1 : 0;
+			if (nodes[n].isReg(Src1) && lastRead[v[Src1]] == n)
+				++tie[n];
+			if (nodes[n].isReg(Src2) && lastRead[v[Src2]] == n
+			&& !(nodes[n].isReg(Src1) && v[Src1] == v[Src2]))
+				++tie[n];
 		}
+	}
+
+	vector<int> order (size);
+	for (int n = 0; n < size; ++n)
+		order[n] = n;
+	auto before = [&](int a, int b) {
+		return weights[a] != weights[b] ? weights[a] < weights[b] : tie[a] < tie[b];
+	};
+	sort(order.begin(), order.end(), before);
+
+	key.assign(size, 0);
+	for (int i = 1; i < size; ++i)
+		key[order[i]] = key[order[i - 1]] + before(order[i - 1], order[i]);
+}
+
 
+// prints the schedule as ILOC, one cycle per line,
+// in the form "[ op1 ; op2 ]". idle units print nop.
+void Scheduler::printSchedule(ostream& os) const {
+	Emitter out {os};
+	for (size_t c = 0; c < slots.size(); c += width) {
+		out.put("[ ");
+		for (int u = 0; u < width; ++u) {
+			if (u)
+				out.put(" ; ");
+			if (slots[c + u] == INVALID)
+				out.put(opcodeNames[nop]);
+			else
+				out.iloc(nodes[slots[c + u]], &vr[NumOperands * slots[c + u]]);
+		}
+		out.put(" ]\n");
 	}
+}
 
+
+// returns the number of cycles an operation takes.
+int Scheduler::latency(Opcode op) {
+	switch (op) {
+		case load:
+		case store:
+			return 3;
+		case mult:
+			return 2;
+		default:
+			return 1;
+	}
 }
 
 
 // assigns a virtual register to each source register.
 // Essentially computeLastUse without tracking nextUse.
+// VRs are kept in vr, NumOperands entries per Node.
 void Scheduler::assignVRs(int n) {
 	int vrName = 0;
 	vector<int> sr2vr (n, INVALID);
+	vr.assign(NumOperands * nodes.size(), INVALID);
 
-	auto it = nodes.end();
-	while (it != nodes.begin()) {
-		--it;
+	for (int i = nodes.size() - 1; i >= 0; --i) {
+		const Instruction& in = nodes[i];
+		int* v = &vr[NumOperands * i];
 		// update and kill dest
-		if ((*it)->i.dest.isReg) {
-			update((*it)->i.dest, sr2vr, vrName);
-			sr2vr[(*it)->i.dest.sr] = INVALID;
+		if (in.isReg(Dest)) {
+			v[Dest] = update(in.operand[Dest], sr2vr, vrName);
+			sr2vr[in.operand[Dest]] = INVALID;
 		}
 		// update src1
-		if ((*it)->i.src1.isReg)
-			update((*it)->i.src1, sr2vr, vrName);
+		if (in.isReg(Src1))
+			v[Src1] = update(in.operand[Src1], sr2vr, vrName);
 		// update src2
-		if ((*it)->i.src2.isReg)
-			update((*it)->i.src2, sr2vr, vrName);
+		if (in.isReg(Src2))
+			v[Src2] = update(in.operand[Src2], sr2vr, vrName);
 	}
+	numVRs = vrName;
 }
 
 
 // helper function for assignVRs.
-// eliminates redundant code.
-void Scheduler::update(Register& op, vector<int>& sr2vr, int& vrName) {
-	if (sr2vr[op.sr] == INVALID)
-		sr2vr[op.sr] = vrName++;
-	op.vr = sr2vr[op.sr];
+// returns the VR live in sr, naming a new one if none is.
+int Scheduler::update(int sr, vector<int>& sr2vr, int& vrName) {
+	if (sr2vr[sr] == INVALID)
+		sr2vr[sr] = vrName++;
+	return sr2vr[sr];
+}
+
+
+// writes the output opts asks for of scheduler, whose
+// ILOC is named name, or with opts.simulate, a summary of
+// running that output from the memory image in header.
+// returns false if the block cannot be allocated (saying
+// why on errs) or the run did not print what the header
+// expects.
+static bool report(Scheduler& scheduler, const string& name,
+		const SimHeader* header, const Options& opts, ostream& os,
+		ostream& errs) {
+	bool ok = true;
+
+	if (opts.schedule)
+		scheduler.listSchedule(opts.machine, opts.heuristics);
+
+	if (opts.registers) {
+		Allocator allocator {scheduler, opts.registers, opts.machine};
+		if (!allocator.error.empty()) {
+			errs << "error: cannot allocate " << name << ": "
+				<< allocator.error << endl;
+			return false;
+		}
+		Clock::time_point start = Clock::now();
+		if (opts.simulate)
+			ok = scheduler.simulate(allocator.code, allocator.width,
+				*header, name, os);
+		else
+			allocator.print(os);
+		scheduler.lap(PrintPhase, start);
+	} else {
+		Clock::time_point start = Clock::now();
+		if (opts.simulate)
+			ok = scheduler.simulate(scheduler.program(),
+				max(scheduler.width, 1), *header, name, os);
+		else if (opts.schedule)
+			scheduler.printSchedule(os);
+		else
+			os << scheduler;
+		scheduler.lap(PrintPhase, start);
+	}
+
+	if (opts.stats)
+		scheduler.printStats(cerr, name);
+	return ok;
+}
+
+
+// writes scheduler's diagnostics to errs in one piece, so
+// those of files scheduled at once do not interleave.
+// returns whether there are none.
+static bool diagnose(const Scheduler& scheduler, ostream& errs) {
+	if (scheduler.diagnostics.empty())
+		return true;
+	std::ostringstream lines;
+	for (const Diagnostic& d : scheduler.diagnostics)
+		lines << d;
+	errs << lines.str();
+	return false;
+}
+
+
+// runs the whole pipeline on infile and writes the
+// requested output to os, or with opts.simulate, a
+// summary of running that output. errors in infile go
+// to errs, and unless opts.recover is set, nothing is
+// written to os. returns false if there were errors, or
+// if the run did not print what the block's header
+// expects.
+bool runScheduler(string infile, const Options& opts, ostream& os,
+		ostream& errs) {
+	// graph construction is actived by constructor.
+	Scheduler scheduler {infile, false, opts};
+	bool clean = diagnose(scheduler, errs);
+	if (!clean && !opts.recover)
+		return false;
+	if (!opts.simulate)
+		return report(scheduler, infile, nullptr, opts, os, errs) && clean;
+	SimHeader header {infile};
+	return report(scheduler, infile, &header, opts, os, errs) && clean;
+}
+
+
+// as above, for the ILOC in text[0, length), named name.
+bool runScheduler(const char* text, size_t length, const string& name,
+		const Options& opts, ostream& os, ostream& errs) {
+	Scheduler scheduler {text, length, name, opts};
+	bool clean = diagnose(scheduler, errs);
+	if (!clean && !opts.recover)
+		return false;
+	if (!opts.simulate)
+		return report(scheduler, name, nullptr, opts, os, errs) && clean;
+	std::istringstream in {string(text, length)};
+	SimHeader header {in};
+	return report(scheduler, name, &header, opts, os, errs) && clean;
+}
+
+
+// the block as printSchedule prints it: width slots per
+// cycle, idle units as nop, naming VRs. an unscheduled
+// block is its Nodes in order, named as written.
+vector<Instruction> Scheduler::program() const {
+	if (!width)
+		return nodes;
+	vector<Instruction> code;
+	code.reserve(slots.size());
+	for (int n : slots) {
+		if (n == INVALID) {
+			code.push_back(Instruction {nop});
+			continue;
+		}
+		Instruction i = nodes[n];
+		for (int o = Src1; o < NumOperands; ++o)
+			if (i.isReg(o))
+				i.operand[o] = vr[NumOperands * n + o];
+		code.push_back(i);
+	}
+	return code;
+}
+
+
+// runs code, w operations per cycle, from the memory image
+// in header, and writes a summary of the run, naming the
+// block name, to os. returns whether the output matched
+// the header.
+bool Scheduler::simulate(const vector<Instruction>& code, int w,
+		const SimHeader& header, const string& name, ostream& os) {
+	Clock::time_point start = Clock::now();
+	Simulator sim {code, w, header};
+	simulated = true;
+	simCycles = sim.cycles;
+	simStalls = sim.stalls;
+	simOk = sim.ok;
+	lap(SimulatePhase, start);
+	sim.report(os, name, header);
+	return sim.ok;
+}
+
+
+// records time elapsed since start as the
+// time spent in phase p, then restarts the clock.
+void Scheduler::lap(Phase p, Clock::time_point& start) {
+	Clock::time_point now = Clock::now();
+	seconds[p] = std::chrono::duration<double>(now - start).count();
+	start = now;
+}
+
+
+// writes timings and counters as a single line of
+// JSON. the line is built first and written in one
+// piece so that batch workers do not interleave.
+void Scheduler::printStats(ostream& os, const string& infile) const {
+	std::ostringstream json;
+
+	json << "{\"file\":\"";
+	for (char c : infile) {
+		if (c == '"' || c == '\\')
+			json << '\\' << c;
+		else if ((unsigned char)c < 0x20) {
+			// control characters may not appear raw in JSON
+			const char* hex = "0123456789abcdef";
+			json << "\\u00" << hex[c >> 4] << hex[c & 15];
+		} else
+			json << c;
+	}
+	json << "\",\"instructions\":" << instructions
+		<< ",\"tokens\":" << tokens
+		<< ",\"cached\":" << (cached ? "true" : "false")
+		<< ",\"nodes\":" << nodes.size()
+		<< ",\"virtualRegisters\":" << numVRs
+		<< ",\"edges\":{\"register\":" << registerEdges
+		<< ",\"serialization\":" << serialEdges << "}"
+		<< ",\"readyPushes\":" << readyPushes
+		<< ",\"graphThreads\":" << graphThreads
+		<< ",\"cycles\":" << (width ? slots.size() / width : 0);
+	if (registers)
+		json << ",\"allocation\":{\"registers\":" << registers
+			<< ",\"spillStores\":" << spillStores
+			<< ",\"spillLoads\":" << spillLoads
+			<< ",\"rematerializations\":" << remats
+			<< ",\"cycles\":" << allocCycles << "}";
+	if (raced & (raced - 1)) {
+		json << ",\"portfolio\":{\"chosen\":\"" << heuristicNames[heuristic] << "\"";
+		for (int h = 0; h < NumHeuristics; ++h)
+			if (raced >> h & 1)
+				json << ",\"" << heuristicNames[h] << "\":{\"cycles\":"
+					<< planCycles[h] << ",\"seconds\":" << planSeconds[h] << "}";
+		json << "}";
+	}
+	if (simulated)
+		json << ",\"simulation\":{\"cycles\":" << simCycles
+			<< ",\"stalls\":" << simStalls
+			<< ",\"ok\":" << (simOk ? "true" : "false") << "}";
+	if (reduced)
+		json << ",\"reduction\":{\"before\":" << registerEdges + serialEdges
+			<< ",\"after\":" << reducedEdges << "}";
+	if (slackFound) {
+		long critical = 0;
+		for (int n = 0; n < (int)nodes.size(); ++n)
+			critical += latestStart[n] == earliestStart[n];
+		json << ",\"criticalPath\":{\"cycles\":"
+			<< (criticalPath.empty() ? 0 : weights[criticalPath[0]])
+			<< ",\"nodes\":" << criticalPath.size()
+			<< ",\"zeroSlack\":" << critical << "}";
+	}
+	if (disambiguated) {
+		int path = 0;
+		for (int w : weights)
+			path = max(path, w);
+		json << ",\"disambiguation\":{\"edgesRemoved\":"
+			<< baselineEdges - serialEdges
+			<< ",\"criticalPath\":{\"before\":" << baselinePath
+			<< ",\"after\":" << path << "}}";
+	}
+	json << ",\"seconds\":{";
+	for (int p = 0; p < NumPhases; ++p)
+		json << (p ? "," : "") << "\"" << phaseNames[p] << "\":" << seconds[p];
+	json << "}}\n";
+
+	os << json.str();
 }
 
 
 // overload of output operator for simple printing.
+// formats through an Emitter: one buffer, no flush
+// per line, and no iostream number formatting.
 ostream& operator<<(ostream& os, const Scheduler& s) {
+	Emitter out {os};
 	// indent padding
-	string pad = "       ";
+	const char* pad = "       n";
+	int size = s.nodes.size();
 
 	// print nodes
-	os << "nodes:" << endl;
-	for (auto n : s.nodes)
-		os << pad << "n" << n->i.label << " : " << n->i;
-	os << endl;
-
-	// print edges
-	vector<int> edges;
-	os << "edges:" << endl;
-	for (auto n : s.nodes) {
-		os << pad << "n" << n->i.label << " : { ";
-		for (auto it = n->children.begin(); it < n->children.end(); ++it) {
-			edges.push_back((*it)->i.label);
-			sort(edges.begin(), edges.end(), [](int x, int y) { return x < y; });
-		}
-		for (auto it = edges.begin(); it != edges.end(); ++it) {
-			os << "n" << *it;
-			if (it != edges.end() - 1)
-				os << ", ";
+	out.put("nodes:\n");
+	for (int n = 0; n < size; ++n) {
+		out.put(pad);
+		out.num(n);
+		out.put(" : ");
+		out.instruction(s.nodes[n], &s.vr[NumOperands * n]);
+	}
+	out.put('\n');
+
+	// print edges (children are already sorted by label)
+	out.put("edges:\n");
+	for (int n = 0; n < size; ++n) {
+		out.put(pad);
+		out.num(n);
+		out.put(" : { ");
+		for (int e = s.childStart[n]; e < s.childStart[n + 1]; ++e) {
+			if (e != s.childStart[n])
+				out.put(", ");
+			out.put('n');
+			out.num(s.children[e]);
 		}
-		os << " }" << endl;
-		edges.clear();
+		out.put(" }\n");
 	}
-	os << endl;
+	out.put('\n');
 
 	// print weights
-	os << "weights:" << endl;
-	for (auto n : s.nodes)
-		os << pad << "n" << n->i.label << " : " << n->weight << endl;
-	os << endl;
+	out.put("weights:\n");
+	for (int n = 0; n < size; ++n) {
+		out.put(pad);
+		out.num(n);
+		out.put(" : ");
+		out.num(s.weights[n]);
+		out.put('\n');
+	}
+	out.put('\n');
+
+	if (!s.slackFound)
+		return os;
+
+	// print start windows
+	out.put("slack:\n");
+	for (int n = 0; n < size; ++n) {
+		out.put(pad);
+		out.num(n);
+		out.put(" : earliest ");
+		out.num(s.earliestStart[n]);
+		out.put(", latest ");
+		out.num(s.latestStart[n]);
+		out.put(", slack ");
+		out.num(s.latestStart[n] - s.earliestStart[n]);
+		out.put('\n');
+	}
+	out.put('\n');
+
+	// print critical path, first Node to issue first
+	out.put("critical path:\n");
+	for (int n : s.criticalPath) {
+		out.put(pad);
+		out.num(n);
+		out.put(" : ");
+		out.instruction(s.nodes[n], &s.vr[NumOperands * n]);
+	}
+	out.put('\n');
 
 	return os;
 }
-
@@ -10,36 +10,240 @@
 
 #pragma once
 
-#include "parser.h"
+#include "emitter.h"
 #include <vector>
-#include <queue>
-#include <algorithm> // for sort, in printing
+#include <queue>	// priority_queue
+#include <utility>	// pair
+#include <functional> // greater, function
+#include <algorithm> // sort, unique, set_union, max, min, remove_if
+#include <iterator>	// back_inserter
+#include <chrono>	// steady_clock
+#include <sstream>	// ostringstream
+#include <thread>
+#include <exception>	// exception_ptr, current_exception(), rethrow_exception()
+#include <system_error>	// system_error
+
+#define MAX_UNITS 16	// most functional units a Machine may have
+#define REDUCE_TILE 256	// Nodes per reachability tile (a multiple of 64)
 
 using std::vector;
-using std::queue;
+using std::priority_queue;
+using std::pair;
+using std::greater;
+using std::max;
+using std::min;
 using std::sort;
+using std::unique;
+using std::set_union;
+using std::back_inserter;
+using std::remove_if;
+using std::thread;
+using std::exception_ptr;
+
+typedef std::chrono::steady_clock Clock;
+
+
+/// Pipeline Phases ///
+enum Phase {
+	ParsePhase,
+	RenamePhase,
+	GraphPhase,
+	ReducePhase,
+	WeightPhase,
+	SlackPhase,
+	SchedulePhase,
+	AllocatePhase,
+	SimulatePhase,
+	PrintPhase,
+	NumPhases
+};
+
+/// Phase names, indexed by Phase ///
+extern const char* const phaseNames[];
+
+
+/// List Scheduling Heuristics ///
+// every forward Heuristic issues the heaviest ready Node
+// first, and differs in how it breaks ties in weight.
+enum Heuristic {
+	WeightHeuristic,	// earlier label
+	FanoutHeuristic,	// more Nodes waiting on it directly
+	PressureHeuristic,	// more registers freed by issuing it
+	BackwardHeuristic,	// schedules the reversed graph, last cycle first
+	NumHeuristics
+};
+
+/// Heuristic names, indexed by Heuristic ///
+extern const char* const heuristicNames[];
+
+
+/// Machine Struct ///
+
+// functional units available to the list scheduler.
+// an operation with opcode op may issue on unit u
+// when bit u of units[op] is set.
+struct Machine {
+	Machine(int w = 2);
+	int width;				// number of functional units
+	unsigned units[nop + 1];	// units each Opcode may issue on
+	// free unit an op of Opcode op should take, given how
+	// many ops of each Opcode are ready (besides it)
+	int unitFor(int op, unsigned freeUnits, const size_t queued[]) const;
+};
+
+
+/// Options Struct ///
+
+// program options shared by every mode of sched.
+struct Options {
+	Options();
+	// fewest registers allocation can work with
+	int minRegisters() const;
+	// what makes these Options unusable, if anything
+	vector<string> problems() const;
+	bool schedule;		// print schedule instead of dependency graph
+	bool stats;			// report timings and counters on stderr
+	Machine machine;	// target of the list scheduler
+	int registers;		// allocate to this many registers, or 0
+	bool cache;			// reuse parsed IR between runs
+	string cacheDir;	// where caches live; empty: next to sources
+	bool disambiguate;	// serialize only memory operations that may alias
+	bool reduce;		// drop edges implied by other paths
+	bool simulate;		// run the output instead of printing it
+	vector<Heuristic> heuristics;	// raced by the list scheduler, in order
+	int graphThreads;	// threads building the dependency graph
+	bool recover;		// skip lines with errors instead of stopping
+	bool slack;			// find start windows and a critical path
+};
 
 
 /// Scheduler Class ///
 
+class Disambiguator;
+struct SimHeader;
+
 class Scheduler {
-	// Node struct for depency graph
-	struct Node {
-		Node(Instruction in);
-		Instruction i;
-		int weight;
-		vector<Node*> parents;
-		vector<Node*> children;
-	};
 	public:
-		Scheduler(string infile, bool = false);
-		~Scheduler();
-		list<Instruction> intRep;
-		vector<Node*> nodes;
+		// takes the file to schedule, whether to print Tokens,
+		// and the Options that shape the graph (cache,
+		// disambiguate and reduce)
+		Scheduler(string infile, bool = false,
+			const Options& opts = Options());
+		// takes ILOC already in memory, text[0, length), which
+		// need only last through the constructor, and the
+		// name to report errors under. opts.cache is ignored.
+		Scheduler(const char* text, size_t length, const string& name,
+			const Options& opts = Options());
+		// holds the only copy of the IR; never copied
+		Scheduler(const Scheduler&) = delete;
+		Scheduler& operator=(const Scheduler&) = delete;
+		// errors in the ILOC. without opts.recover, the Nodes
+		// are those before the first; with it, every line
+		// without one.
+		vector<Diagnostic> diagnostics;
+		vector<Instruction> nodes;	// Instruction at each Node
+		vector<int> vr;				// VR of each operand of each Node
+		vector<int> weights;		// latency-weighted distance to root
+		// with opts.slack: the first and last cycles each Node
+		// could issue in, on unlimited units, without making
+		// the block longer than its longest path, and one
+		// such path, first Node to issue first
+		vector<int> earliestStart;
+		vector<int> latestStart;
+		vector<int> criticalPath;
+		// dependency graph. Nodes are indexed by label and
+		// edges are kept in compressed sparse row form: the
+		// children of Node n are children[childStart[n]]
+		// up to children[childStart[n + 1]], sorted by label.
+		// parents/parentStart hold the reverse edges.
+		vector<int> childStart;
+		vector<int> children;
+		vector<int> parentStart;
+		vector<int> parents;
+		// schedule. slots holds width entries per cycle, each the
+		// label of the Node issued on that unit or INVALID (nop).
+		vector<int> issue;			// cycle each Node issues in
+		vector<int> slots;
+		int width;
+		Heuristic heuristic;		// made the schedule kept
+		unsigned raced;				// Heuristics listSchedule ran, a bit each
+		int planCycles[NumHeuristics];		// length of each one's schedule
+		double planSeconds[NumHeuristics];	// time each one took
+		double seconds[NumPhases];	// wall time spent in each phase
+		// counters reported by --stats
+		long instructions;		// Instructions parsed, nops included
+		bool cached;			// IR was loaded from the cache
+		long tokens;			// Tokens scanned
+		long registerEdges;		// edges from a register dependence
+		long serialEdges;		// edges from serialization only
+		long readyPushes;		// Nodes entering list scheduler queues
+		int graphThreads;		// threads that built the graph
+		int registers;			// registers allocated to, or 0
+		long spillStores;		// values stored to spill memory
+		long spillLoads;		// values reloaded from spill memory
+		long remats;			// values recomputed by loadI
+		long allocCycles;		// cycles after allocation
+		bool disambiguated;		// graph was built with a Disambiguator
+		long baselineEdges;		// serialization edges without one
+		int baselinePath;		// critical path without one
+		bool reduced;			// graph went through reduceGraph
+		long reducedEdges;		// edges it left
+		bool slackFound;		// computeSlack ran
+		bool simulated;			// output was run by a Simulator
+		long simCycles;			// cycles it took
+		long simStalls;			// cycles it stalled
+		bool simOk;				// outputs matched the block's header
+		void listSchedule(const Machine& m,
+			const vector<Heuristic>& heuristics =
+				vector<Heuristic> {WeightHeuristic});
+		void printSchedule(ostream& os) const;
+		vector<Instruction> program() const;
+		bool simulate(const vector<Instruction>& code, int w,
+			const SimHeader& header, const string& name, ostream& os);
+		void lap(Phase p, Clock::time_point& start);
+		void printStats(ostream& os, const string& infile) const;
+		static int latency(Opcode op);
 	private:
-		void buildDepGraph();
+		// a schedule made by one Heuristic. making one only
+		// reads the graph, so several can be made at once.
+		struct Plan {
+			vector<int> issue;
+			vector<int> slots;
+			long pushes;		// Nodes entering its queues
+			int cycles;			// until its last result lands
+		};
+		int numVRs;		// number of virtual registers assigned
+		vector<int> fanout;	// parents of each Node before reduceGraph
+		Scheduler(const Options& opts);
+		void takeIR(Parser& parser, Clock::time_point& start);
+		void analyze(const Options& opts, Clock::time_point& start);
+		void buildDepGraph(Disambiguator* alias = nullptr);
+		void buildDepGraph(int threads);
+		void buildParents();
+		void reduceGraph();
 		void computeWeights();
+		void computeSlack();
+		Plan plan(const Machine& m, Heuristic h) const;
+		Plan planBackward(const Machine& m) const;
+		void priorities(Heuristic h, vector<int>& key) const;
 		void assignVRs(int n);
-		void update(Register& op, vector<int>& sr2vr, int& vrName);
+		int update(int sr, vector<int>& sr2vr, int& vrName);
+		// IR cache (see cache.cpp)
+		bool loadIR(const string& path, uint64_t size, uint64_t hash);
+		void saveIR(const string& path, uint64_t size, uint64_t hash) const;
 		friend ostream& operator<<(ostream& os, const Scheduler& s);
+		friend class Allocator;
+		friend class Disambiguator;
 };
+
+
+// runs the whole pipeline on infile and writes the
+// requested output to os, and any errors in infile to
+// errs. returns false if there were errors, or if a
+// simulated run did not print what the block's header
+// expects.
+bool runScheduler(string infile, const Options& opts, ostream& os,
+	ostream& errs = cerr);
+// as above, for the ILOC in text[0, length), named name
+bool runScheduler(const char* text, size_t length, const string& name,
+	const Options& opts, ostream& os, ostream& errs = cerr);
@@ -0,0 +1,229 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                         *
+ * server.cpp                                              *
+ *                                                         *
+ * Contains implementations for everything in server.h.    *
+ *                                                         *
+ * A process answering many requests pays for starting up  *
+ * once. Each thread keeps its request and report buffers  *
+ * from one request to the next, and with --cache the IR   *
+ * of files already seen is reused as it is by sched.      *
+ *                                                         *
+ * Written by: Austin James Lee                            *
+ *                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "server.h"
+
+
+//// public Server methods ////
+
+
+// constructor.
+Server::Server(const Options& o, int t) :opts(o), threads{t} {
+	if (threads < 1)
+		threads = 1;
+}
+
+
+// answers requests on in, in order, on this thread.
+long Server::serve(istream& in, ostream& out) {
+	string payload;
+	std::ostringstream report;
+	long served = 0;
+	while (answer(in, out, payload, report))
+		++served;
+	return served;
+}
+
+
+// binds a socket at path (replacing a socket left by an
+// earlier server, but nothing else) and answers connections on a pool of
+// threads, each taking the next connection once it is
+// done with the last. a connection may send any number
+// of requests. a worker that cannot accept (having run
+// out of descriptors, say) reports it and waits
+// SERVE_BACKOFF ms before trying again.
+bool Server::listen(const string& path) {
+	struct sockaddr_un addr {};
+	addr.sun_family = AF_UNIX;
+	if (path.size() >= sizeof addr.sun_path) {
+		cerr << "error: socket path too long: " << path << endl;
+		return false;
+	}
+	strcpy(addr.sun_path, path.c_str());
+
+	struct stat st;
+	if (lstat(path.c_str(), &st) == 0) {
+		if (!S_ISSOCK(st.st_mode)) {
+			cerr << "error: not a socket, will not replace: " << path << endl;
+			return false;
+		}
+		unlink(path.c_str());
+	}
+
+	int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock < 0 || bind(sock, (struct sockaddr*)&addr, sizeof addr) != 0
+	|| ::listen(sock, SERVE_BACKLOG) != 0) {
+		cerr << "error: cannot listen on " << path << endl;
+		return false;
+	}
+
+	auto work = [this, sock]() {
+		string payload;
+		std::ostringstream report;
+		while (true) {
+			int fd = accept(sock, nullptr, nullptr);
+			if (fd < 0) {
+				if (errno == EINTR || errno == ECONNABORTED)
+					continue;
+				// out of descriptors, say: wait for some to close
+				std::ostringstream line;
+				line << "error: cannot accept: " << strerror(errno) << "\n";
+				cerr << line.str();
+				std::this_thread::sleep_for(
+					std::chrono::milliseconds(SERVE_BACKOFF));
+				continue;
+			}
+			{
+				SocketBuf buf {fd};
+				istream in {&buf};
+				ostream out {&buf};
+				while (answer(in, out, payload, report))
+					;
+			}
+			close(fd);
+		}
+	};
+
+	vector<thread> pool;
+	for (int t = 0; t < threads; ++t)
+		pool.push_back(thread {work});
+	for (auto& t : pool)
+		t.join();
+	return true;
+}
+
+
+//// private Server methods ////
+
+
+// reads one request from in and writes its response,
+// flushed, to out. a request too long to hold is read
+// past and fails, as does one the scheduler runs out of
+// memory on; a length that is not a number fails and
+// ends the connection, since the request cannot be found
+// in what follows.
+bool Server::answer(istream& in, ostream& out, string& payload,
+		std::ostringstream& report) {
+	string line;
+	if (!getline(in, line))
+		return false;
+
+	report.str("");
+	report.clear();
+	bool ok = false;
+	bool framed = true;		// the next request can still be found
+	struct stat st;
+	try {
+		if (line.compare(0, 5, "file ") == 0) {
+			string path = line.substr(5);
+			if (stat(path.c_str(), &st) == 0 && !S_ISDIR(st.st_mode))
+				ok = runScheduler(path, opts, report, report);
+			else
+				report << "error: invalid filename: " << path << "\n";
+		} else if (line.compare(0, 5, "iloc ") == 0) {
+			const char* digits = line.c_str() + 5;
+			char* stop;
+			errno = 0;
+			long length = strtol(digits, &stop, 10);
+			if (stop == digits || *stop != '\0' || errno || length < 0) {
+				report << "error: invalid length: " << digits << "\n";
+				framed = false;
+			} else if (length > SERVE_MAX_REQUEST) {
+				report << "error: request of " << length
+					<< " bytes is longer than " << SERVE_MAX_REQUEST << "\n";
+				in.ignore(length);
+			} else {
+				payload.resize(length);
+				if (!in.read(&payload[0], length))
+					return false;
+				ok = runScheduler(payload.data(), length, SERVE_NAME, opts,
+					report, report);
+			}
+		} else
+			report << "error: unknown request: " << line << "\n";
+	} catch (const std::bad_alloc&) {
+		report.str("");
+		report.clear();
+		report << "error: out of memory\n";
+		ok = false;
+	}
+
+	const string& r = report.str();
+	out << (ok ? "ok " : "error ") << r.size() << '\n';
+	out.write(r.data(), r.size());
+	out.flush();
+	return framed;
+}
+
+
+//// SocketBuf methods ////
+
+
+// constructor.
+SocketBuf::SocketBuf(int f) :fd{f} {
+	setg(in, in, in);
+	setp(out, out + sizeof out);
+}
+
+
+// deconstructor.
+SocketBuf::~SocketBuf() {
+	sync();
+}
+
+
+// refills the input buffer from the socket.
+int SocketBuf::underflow() {
+	ssize_t n;
+	do
+		n = recv(fd, in, sizeof in, 0);
+	while (n < 0 && errno == EINTR);
+	if (n <= 0)
+		return traits_type::eof();
+	setg(in, in, in + n);
+	return traits_type::to_int_type(*in);
+}
+
+
+// makes room in the output buffer, then appends c.
+int SocketBuf::overflow(int c) {
+	if (sync() != 0)
+		return traits_type::eof();
+	if (c != traits_type::eof()) {
+		*pptr() = c;
+		pbump(1);
+	}
+	return traits_type::not_eof(c);
+}
+
+
+// sends everything in the output buffer. a client that
+// has gone away fails the send rather than raising
+// SIGPIPE.
+int SocketBuf::sync() {
+	const char* p = pbase();
+	while (p < pptr()) {
+		ssize_t n = send(fd, p, pptr() - p, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0) {
+			setp(out, out + sizeof out);
+			return -1;
+		}
+		p += n;
+	}
+	setp(out, out + sizeof out);
+	return 0;
+}
@@ -0,0 +1,85 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                         *
+ * server.h                                                *
+ *                                                         *
+ * Contains declarations for Server class, which answers   *
+ * scheduling requests for as long as it runs, on stdin    *
+ * and stdout or on a Unix domain socket, and SocketBuf    *
+ * class, which lets a socket be read and written as a     *
+ * stream, as well as all necessary includes and using     *
+ * statements not already present in scheduler.h.          *
+ *                                                         *
+ * Written by: Austin James Lee                            *
+ *                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+
+#include "scheduler.h"
+#include <streambuf>
+#include <new>			// bad_alloc
+#include <cerrno>		// errno, EINTR, ECONNABORTED
+#include <sys/socket.h>	// socket(), bind(), listen(), accept(), send()
+#include <sys/un.h>		// sockaddr_un
+
+#define SERVE_BUFFER 65536		// bytes buffered each way on a socket
+#define SERVE_MAX_REQUEST (1L << 28)	// most bytes of ILOC in one request
+#define SERVE_BACKLOG 64		// connections waiting to be accepted
+#define SERVE_BACKOFF 100		// ms to wait after accept fails
+#define SERVE_NAME "<request>"	// what ILOC sent as text is called
+
+using std::istream;
+using std::cin;
+
+
+//// Server class ////
+
+// every request is one line, optionally followed by data:
+//	file <path>\n				schedules the file at path
+//	iloc <length>\n<ILOC>		schedules length bytes of ILOC
+// and every response is a status line and the report:
+//	ok <length>\n<report>		or "error" in place of "ok"
+// the report is what sched would print for the same block
+// with the server's Options, preceded by any errors in
+// the ILOC. a request fails if its file is missing, if
+// its ILOC has errors or is longer than SERVE_MAX_REQUEST
+// bytes, if scheduling it runs out of memory, or if a
+// simulated run's output differs from the block's header.
+class Server {
+	public:
+		// takes the Options applied to every request and the
+		// number of threads answering socket connections
+		Server(const Options& o, int t);
+		// answers requests on in until it ends, returning the
+		// number answered
+		long serve(istream& in, ostream& out);
+		// answers connections to a socket at path until killed.
+		// returns false if the socket cannot be made
+		bool listen(const string& path);
+	private:
+		Options opts;			// options applied to every request
+		int threads;			// threads answering connections
+		// answers one request; false once in ends (or cannot
+		// be followed past a bad length). payload and
+		// report are reused from one request to the next
+		bool answer(istream& in, ostream& out, string& payload,
+			std::ostringstream& report);
+};
+
+
+//// SocketBuf class ////
+
+// buffers a connected socket both ways.
+class SocketBuf : public std::streambuf {
+	public:
+		SocketBuf(int fd);		// takes the socket; does not close it
+		~SocketBuf();			// sends anything still buffered
+	protected:
+		int underflow();		// receives more input
+		int overflow(int c);	// sends the output buffer, then c
+		int sync();				// sends the output buffer
+	private:
+		int fd;					// connected socket
+		char in[SERVE_BUFFER];	// bytes received, not yet read
+		char out[SERVE_BUFFER];	// bytes written, not yet sent
+};
@@ -0,0 +1,211 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                         *
+ * simulator.cpp                                           *
+ *                                                         *
+ * Contains implementations for everything in simulator.h. *
+ *                                                         *
+ * A result is written as soon as its operation issues,    *
+ * together with the cycle it lands in; the interlock      *
+ * keeps anything from reading or overwriting it sooner.   *
+ * Every operation of a cycle is computed before any of    *
+ * them writes, so they all see the values the cycle       *
+ * began with.                                             *
+ *                                                         *
+ * Written by: Austin James Lee                            *
+ *                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "simulator.h"
+
+
+//// SimHeader constructor ////
+
+
+// reads the header of infile.
+SimHeader::SimHeader(const string& infile) :base{0}, checked{false} {
+	ifstream f (infile);
+	read(f);
+}
+
+
+// reads the header of the ILOC on in.
+SimHeader::SimHeader(istream& in) :base{0}, checked{false} {
+	read(in);
+}
+
+
+// reads the comment lines before the first operation.
+// "//SIM INPUT: -i <base> <values>" gives the memory image
+// and "//OUTPUT: <values>" the expected output.
+void SimHeader::read(istream& in) {
+	string line;
+	while (getline(in, line)) {
+		size_t first = line.find_first_not_of(" \t\r");
+		if (first == string::npos)
+			continue;
+		if (line.compare(first, 2, "//") != 0)
+			break;
+
+		std::istringstream fields;
+		int v;
+		if (line.compare(first, strlen(SIM_INPUT), SIM_INPUT) == 0) {
+			fields.str(line.substr(first + strlen(SIM_INPUT)));
+			string flag;
+			if (fields >> flag && flag == "-i" && fields >> base)
+				while (fields >> v)
+					input.push_back(v);
+		} else if (line.compare(first, strlen(SIM_OUTPUT), SIM_OUTPUT) == 0) {
+			fields.str(line.substr(first + strlen(SIM_OUTPUT)));
+			checked = true;
+			while (fields >> v)
+				expected.push_back(v);
+		}
+	}
+}
+
+
+
+//// public Simulator methods ////
+
+
+// Simulator constructor.
+//
+// issues code a cycle (width slots) at a time. a cycle
+// whose operations are blocked by writes in flight
+// waits, counting a stall each time, and then issues
+// whole. the block is done once the last write lands.
+Simulator::Simulator(const vector<Instruction>& code, int width,
+		const SimHeader& h)
+		:cycles{0}, stalls{0}, operations{0}, ok{true} {
+	int highReg = -1;
+	for (const Instruction& i : code)
+		for (int o = Src1; o < NumOperands; ++o)
+			if (i.isReg(o))
+				highReg = max(highReg, (int)i.operand[o]);
+	value.assign(highReg + 1, 0);
+	ready.assign(highReg + 1, 0);
+	for (size_t v = 0; v < h.input.size(); ++v)
+		memory[h.base + SIM_WORD * (int)v] = h.input[v];
+
+	vector<int> results (width);
+	long cycle = 1;
+	for (size_t c = 0; c < code.size(); c += width) {
+		bool wait;
+		do {
+			wait = false;
+			for (int u = 0; u < width; ++u)
+				wait = wait || blocked(code[c + u], cycle);
+			if (wait) {
+				++cycle;
+				++stalls;
+			}
+		} while (wait);
+
+		// read everything, then write everything
+		for (int u = 0; u < width; ++u)
+			results[u] = compute(code[c + u]);
+		for (int u = 0; u < width; ++u) {
+			const Instruction& i = code[c + u];
+			if (i.op == nop)
+				continue;
+			++operations;
+			long lands = cycle + Scheduler::latency((Opcode)i.op);
+			cycles = max(cycles, lands - 1);
+			if (i.op == store) {
+				memory[value[i.operand[Src2]]] = results[u];
+				landing[value[i.operand[Src2]]] = lands;
+			} else if (i.op == output)
+				outputs.push_back(results[u]);
+			else {
+				value[i.operand[Dest]] = results[u];
+				ready[i.operand[Dest]] = lands;
+			}
+		}
+		++cycle;
+	}
+
+	if (h.checked)
+		ok = outputs == h.expected;
+}
+
+
+// writes a one line summary of the run, and what the
+// header expected if the outputs do not match it.
+void Simulator::report(ostream& os, const string& infile,
+		const SimHeader& h) const {
+	std::ostringstream line;
+	line << infile << ": " << cycles << " cycles, " << stalls
+		<< " stalls, " << operations << " operations, output ";
+	for (size_t v = 0; v < outputs.size(); ++v)
+		line << (v ? " " : "") << outputs[v];
+	if (!ok) {
+		line << "; MISMATCH, expected";
+		for (int v : h.expected)
+			line << " " << v;
+	}
+	line << "\n";
+	os << line.str();
+}
+
+
+//// private Simulator methods ////
+
+
+// tells whether i must wait past cycle for a register it
+// reads or writes, or an address it reads, to be written.
+bool Simulator::blocked(const Instruction& i, long cycle) const {
+	for (int o = Src1; o < NumOperands; ++o)
+		if (i.isReg(o) && ready[i.operand[o]] > cycle)
+			return true;
+	if (i.op == load)
+		return memReady(value[i.operand[Src1]]) > cycle;
+	if (i.op == output)
+		return memReady(i.operand[Src1]) > cycle;
+	return false;
+}
+
+
+// returns the value i writes (or, for output, prints),
+// reading registers and memory as they are now.
+// arithmetic wraps at 32 bits; shifts by less than 0 or
+// more than 31 shift every bit out.
+int Simulator::compute(const Instruction& i) const {
+	const int* r = i.operand;
+	unsigned a = i.isReg(Src1) ? value[r[Src1]] : 0;
+	unsigned b = i.isReg(Src2) ? value[r[Src2]] : 0;
+	switch (i.op) {
+		case load: {
+			auto m = memory.find(a);
+			return m == memory.end() ? 0 : m->second;
+		}
+		case loadI:
+			return r[Src1];
+		case store:
+			return a;
+		case add:
+			return a + b;
+		case sub:
+			return a - b;
+		case mult:
+			return a * b;
+		case lshift:
+			return b < 32 ? a << b : 0;
+		case rshift:
+			if (b < 32)
+				return (int)a >> b;
+			return (int)a < 0 ? -1 : 0;
+		case output: {
+			auto m = memory.find(r[Src1]);
+			return m == memory.end() ? 0 : m->second;
+		}
+		default:
+			return 0;
+	}
+}
+
+
+// returns the cycle the last store to addr lands in
+long Simulator::memReady(int addr) const {
+	auto l = landing.find(addr);
+	return l == landing.end() ? 0 : l->second;
+}
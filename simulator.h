@@ -0,0 +1,76 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                         *
+ * simulator.h                                             *
+ *                                                         *
+ * Contains declarations for SimHeader structure, which    *
+ * reads the memory image and expected output a block      *
+ * declares in its header comments, and Simulator class,   *
+ * a cycle-accurate interpreter for (possibly bundled)     *
+ * ILOC, as well as all necessary includes and using       *
+ * statements not already present in scheduler.h.          *
+ *                                                         *
+ * Written by: Austin James Lee                            *
+ *                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+
+#include "scheduler.h"
+#include <unordered_map>
+
+#define SIM_INPUT "//SIM INPUT:"	// header line giving -i <addr> <values>
+#define SIM_OUTPUT "//OUTPUT:"		// header line giving expected output
+#define SIM_WORD 4					// bytes between consecutive -i values
+
+using std::unordered_map;
+using std::istream;
+
+
+//// SimHeader structure ////
+
+// what a block's header comments say about running it:
+//	//SIM INPUT: -i 128 8 12 5	(values stored from 128 up)
+//	//OUTPUT: 68				(values output should print)
+struct SimHeader {
+	SimHeader(const string& infile);	// reads header of infile
+	SimHeader(istream& in);				// reads header of ILOC on in
+	int base;				// address of first input value
+	vector<int> input;		// values stored from base up
+	bool checked;			// header gave an expected output
+	vector<int> expected;	// values output should print
+	private:
+		void read(istream& in);
+};
+
+
+//// Simulator class ////
+
+// runs code one cycle at a time, width operations per
+// cycle, with the latencies computeWeights assumes.
+// every operation in a cycle reads its operands as the
+// cycle begins. a cycle stalls until every register it
+// reads or writes and every address it loads or outputs
+// has no write still in flight.
+class Simulator {
+	public:
+		// runs code, registers named by its operand fields,
+		// from the memory image in h
+		Simulator(const vector<Instruction>& code, int width,
+			const SimHeader& h);
+		vector<int> outputs;	// values printed by output
+		long cycles;			// cycles until the last result lands
+		long stalls;			// cycles no operation could issue in
+		long operations;		// operations executed, nops excluded
+		bool ok;				// outputs match the header, if it has one
+		// one line summary, naming infile and checking against h
+		void report(ostream& os, const string& infile,
+			const SimHeader& h) const;
+	private:
+		vector<int> value;		// value of each register
+		vector<long> ready;		// cycle each register's value lands
+		unordered_map<int, int> memory;		// address -> value
+		unordered_map<int, long> landing;	// address -> cycle store lands
+		bool blocked(const Instruction& i, long cycle) const;
+		int compute(const Instruction& i) const;
+		long memReady(int addr) const;
+};
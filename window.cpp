@@ -0,0 +1,316 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                         *
+ * window.cpp                                              *
+ *                                                         *
+ * Contains implementation of Window class.                *
+ *                                                         *
+ * The window is refilled only once half of it has left,  *
+ * and then reweighed in one pass from the newest Node     *
+ * down, so weights cost no more per Node than they do in  *
+ * Scheduler::computeWeights however large the window is.  *
+ * Raising weights as each Node arrived instead would walk *
+ * the whole window for every link of a long chain.        *
+ *                                                         *
+ * Written by: Austin James Lee                            *
+ *                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "window.h"
+
+
+// Window constructor.
+// opens infile for streaming; nothing is read until
+// one of the print methods runs.
+Window::Window(const string& infile, int size, const Machine& m,
+		bool recover) :parser{infile, false, true, recover}, size{size},
+		m{m}, ring(size), oldest{0}, next{0}, eof{false},
+		scheduling{false}, printed{0}, lastLanding{0}, vrName{0},
+		lastStore{INVALID}, lastOutput{INVALID}, storeLanded{0},
+		outputLanded{0}, loadsLanded{0} {}
+
+
+// prints the weights section of the dependency graph in
+// the same form as operator<<(ostream&, const Scheduler&).
+// Nodes leave in order, each with the weight it had when
+// the window was last refilled.
+void Window::printWeights(ostream& os) {
+	Emitter out {os};
+	out.put("weights:\n");
+	for (fill(); oldest < next; fill()) {
+		out.put("       n");
+		out.num(oldest);
+		out.put(" : ");
+		out.num(at(oldest).weight);
+		out.put('\n');
+		leave(oldest, 0);
+	}
+	out.put('\n');
+}
+
+
+// cycle-by-cycle list scheduler, as in
+// Scheduler::listSchedule, over the Nodes in the window.
+// a cycle is printed as soon as it is filled, and the
+// window refilled before the next one.
+void Window::printSchedule(ostream& os) {
+	Emitter out {os};
+	vector<int64_t> slots (m.width);
+	scheduling = true;
+
+	fill();
+	for (int64_t cycle = 1; oldest < next; ++cycle) {
+
+		// move Nodes whose operands are now available to ready
+		while (!pending.empty() && pending.top().first <= cycle) {
+			Node& n = at(pending.top().second);
+			pending.pop();
+			ready[n.in.op].push(Entry {n.weight, -n.label});
+		}
+
+		unsigned freeUnits = (1u << m.width) - 1;
+		slots.assign(m.width, INVALID);
+		while (freeUnits) {
+			// heaviest ready Node that has a free unit
+			int best = INVALID;
+			for (int op = load; op <= nop; ++op)
+				if (!ready[op].empty() && (m.units[op] & freeUnits)
+				&& (best == INVALID || ready[best].top() < ready[op].top()))
+					best = op;
+			if (best == INVALID)
+				break;
+
+			int64_t n = -ready[best].top().second;
+			ready[best].pop();
+
+			// the free unit it may use that others need least
+			size_t queued[nop + 1];
+			for (int o = load; o <= nop; ++o)
+				queued[o] = ready[o].size();
+			int u = m.unitFor(best, freeUnits, queued);
+			freeUnits &= ~(1u << u);
+			slots[u] = n;
+			leave(n, cycle);
+		}
+
+		// Nodes stay in the ring until fill() reuses them
+		out.put("[ ");
+		for (int u = 0; u < m.width; ++u) {
+			if (u)
+				out.put(" ; ");
+			if (slots[u] == INVALID)
+				out.put(opcodeNames[nop]);
+			else
+				out.iloc(at(slots[u]).in);
+		}
+		out.put(" ]\n");
+
+		printed = cycle;
+		fill();
+	}
+}
+
+
+//// private Window methods ////
+
+
+// once at most half the window is in use, reads Nodes
+// (dropping nops) until it is full or the stream ends,
+// and reweighs it.
+void Window::fill() {
+	if (eof || next - oldest > size / 2)
+		return;
+	Instruction in;
+	while (!eof && next - oldest < size) {
+		if (!parser.next(in))
+			eof = true;
+		else if (in.op != nop)
+			add(in);
+	}
+	reweigh();
+}
+
+
+// sets the weight of every Node in the window to its
+// latency-weighted distance to the newest, as
+// Scheduler::computeWeights, and reorders ready to suit.
+// parents arrive after their children and leave after
+// them, so every parent of a Node in the window is too.
+void Window::reweigh() {
+	for (int64_t l = next - 1; l >= oldest; --l) {
+		Node& n = at(l);
+		if (n.left)
+			continue;
+		int above = 0;
+		for (int64_t p : n.parents)
+			above = max(above, at(p).weight);
+		n.weight = above + Scheduler::latency((Opcode)n.in.op);
+	}
+
+	for (auto& queue : ready) {
+		vector<Entry> entries;
+		for (; !queue.empty(); queue.pop())
+			entries.push_back(queue.top());
+		for (Entry e : entries)
+			queue.push(Entry {at(-e.second).weight, e.second});
+	}
+}
+
+
+// adds in as the newest Node. its children are the Nodes
+// it depends on that are still in the window; those that
+// have left only delay it until their results land.
+void Window::add(Instruction in) {
+	Node& n = at(next);
+	n.in = in;
+	n.label = next;
+	n.sr = INVALID;
+	n.weight = Scheduler::latency((Opcode)in.op);
+	n.earliest = 1;
+	n.waiting = 0;
+	n.left = false;
+	n.parents.clear();
+	children.clear();
+
+	// Register Edges (sources before the definition)
+	for (int o = Src1; o <= Src2; ++o)
+		if (in.isReg(o)) {
+			int sr = in.operand[o];
+			n.in.operand[o] = rename(sr, false);
+			depend(n, def[sr], landed[sr]);
+		}
+
+	// Serialization Edges
+	switch (in.op) {
+		case load:
+			depend(n, lastStore, storeLanded);
+			loads.push_back(n.label);
+			break;
+		case store:
+			depend(n, lastStore, storeLanded);
+			depend(n, lastOutput, outputLanded);
+			// earlier loads are behind lastStore
+			for (int64_t l : loads)
+				if (!at(l).left)
+					depend(n, l, 0);
+			depend(n, INVALID, loadsLanded);
+			loads.clear();
+			loadsLanded = 0;
+			lastStore = n.label;
+			break;
+		case output:
+			depend(n, lastStore, storeLanded);
+			depend(n, lastOutput, outputLanded);
+			lastOutput = n.label;
+			break;
+		default:
+			break;
+	}
+
+	if (in.isReg(Dest)) {
+		n.sr = in.operand[Dest];
+		n.in.operand[Dest] = rename(n.sr, true);
+		def[n.sr] = n.label;
+	}
+
+	// add the edges
+	sort(children.begin(), children.end());
+	children.erase(unique(children.begin(), children.end()), children.end());
+	for (int64_t c : children) {
+		at(c).parents.push_back(n.label);
+		++n.waiting;
+	}
+
+	if (scheduling && n.waiting == 0)
+		pending.push(Entry {n.earliest, n.label});
+	++next;
+}
+
+
+// makes child (a Node in the window, or INVALID) a child
+// of n, or if there is no such Node, delays n until
+// landedAt.
+void Window::depend(Node& n, int64_t child, int64_t landedAt) {
+	if (child != INVALID)
+		children.push_back(child);
+	else
+		n.earliest = max(n.earliest, landedAt);
+}
+
+
+// returns the VR holding source register sr, naming a
+// new one if sr is being defined or has never been seen.
+// the VR a definition replaces is free once every Node
+// up to the new one has left (so none can read it) and
+// everything issued by then has landed (so it cannot be
+// overwritten late); definitions take free VRs first.
+int Window::rename(int sr, bool define) {
+	if (sr >= (int)sr2vr.size()) {
+		sr2vr.resize(sr + 1, INVALID);
+		def.resize(sr + 1, INVALID);
+		landed.resize(sr + 1, 0);
+	}
+	if (!define) {
+		if (sr2vr[sr] == INVALID)
+			sr2vr[sr] = vrName++;
+		return sr2vr[sr];
+	}
+
+	if (sr2vr[sr] != INVALID)
+		superseded.push_back({next, sr2vr[sr]});
+	while (!superseded.empty() && superseded.front().first < oldest) {
+		retired.push_back({lastLanding, superseded.front().second});
+		superseded.pop_front();
+	}
+	// the new definition issues after printed, landing at
+	// least a cycle later still
+	if (!retired.empty()
+	&& (!scheduling || retired.front().first <= printed + 1)) {
+		sr2vr[sr] = retired.front().second;
+		retired.pop_front();
+	} else
+		sr2vr[sr] = vrName++;
+	return sr2vr[sr];
+}
+
+
+// takes Node label out of the window as it issues in
+// cycle: Nodes arriving later that depend on it wait for
+// its result to land instead, and parents waiting only on
+// it become pending.
+void Window::leave(int64_t label, int64_t cycle) {
+	Node& n = at(label);
+	int64_t lands = cycle + Scheduler::latency((Opcode)n.in.op);
+	n.left = true;
+	lastLanding = max(lastLanding, lands);
+
+	if (n.sr != INVALID && def[n.sr] == label) {
+		def[n.sr] = INVALID;
+		landed[n.sr] = lands;
+	}
+	if (lastStore == label) {
+		lastStore = INVALID;
+		storeLanded = lands;
+	}
+	if (lastOutput == label) {
+		lastOutput = INVALID;
+		outputLanded = lands;
+	}
+	// loads may issue out of order, so those behind the
+	// oldest still waiting stay until it leaves
+	if (n.in.op == load && !loads.empty() && label >= loads.front()) {
+		loadsLanded = max(loadsLanded, lands);
+		while (!loads.empty() && at(loads.front()).left)
+			loads.pop_front();
+	}
+
+	if (scheduling)
+		for (int64_t p : n.parents) {
+			Node& parent = at(p);
+			parent.earliest = max(parent.earliest, lands);
+			if (--parent.waiting == 0)
+				pending.push(Entry {parent.earliest, p});
+		}
+
+	while (oldest < next && at(oldest).left)
+		++oldest;
+}
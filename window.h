@@ -0,0 +1,103 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                         *
+ * window.h                                                *
+ *                                                         *
+ * Contains declaration for Window class, which schedules  *
+ * a stream of ILOC of any length in memory bounded by a   *
+ * fixed number of Instructions, as well as all necessary  *
+ * includes and using statements not already present in   *
+ * scheduler.h.                                            *
+ *                                                         *
+ * Written by: Austin James Lee                            *
+ *                                                         *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+
+#include "scheduler.h"
+#include <cstdint>	// int64_t
+#include <deque>
+
+using std::deque;
+
+
+//// Window class ////
+
+// holds the dependency graph of at most size consecutive
+// Nodes of the stream: the oldest Node not yet issued and
+// those after it. Nodes leave the window as they issue
+// (or, for weights, in order), and more are read once
+// half of it is empty, so weights see between size / 2
+// and size Nodes ahead.
+//
+// registers are renamed as Nodes arrive, each definition
+// naming a VR no Node in the window may still read, so
+// only true dependences and memory order need edges. a
+// dependence on a Node that has left becomes the cycle
+// its result lands in. labels and cycles are 64 bits, as
+// the stream may outlast an int.
+class Window {
+	public:
+		// takes the ILOC to read (a file name, or "-" for
+		// stdin), the window size, the target Machine, and
+		// whether to skip lines with errors (see Parser)
+		Window(const string& infile, int size, const Machine& m,
+			bool recover = false);
+		// prints the weights section of the dependency graph,
+		// each Node's weight as it leaves
+		void printWeights(ostream& os);
+		// list schedules the stream, printing each cycle as
+		// [ op1 ; op2 ] once it is filled
+		void printSchedule(ostream& os);
+		// errors found in the stream so far; the stream ends
+		// at the first unless recovering
+		const vector<Diagnostic>& diagnostics() const
+			{ return parser.diagnostics; }
+	private:
+		// a Node in the window, kept at label % size
+		struct Node {
+			Instruction in;		// operands renamed to VRs
+			int64_t label;
+			int sr;				// source register defined, or INVALID
+			int weight;			// latency-weighted distance to newest
+			int64_t earliest;	// first cycle operands are ready
+			int waiting;		// children not yet issued
+			bool left;			// issued, or printed
+			vector<int64_t> parents;
+		};
+		typedef pair<int64_t, int64_t> Entry;
+		Parser parser;
+		int size;
+		const Machine& m;
+		vector<Node> ring;
+		int64_t oldest;			// label of oldest Node not left
+		int64_t next;			// label the next Node will get
+		bool eof;				// stream exhausted
+		bool scheduling;		// printSchedule is running
+		int64_t printed;		// last cycle printSchedule printed
+		int64_t lastLanding;	// latest cycle a result lands in
+		vector<int64_t> children;	// of the Node being added
+		// VR names, reused once nothing can read them
+		int vrName;				// next VR never named
+		deque<pair<int64_t, int>> superseded;	// (redefining Node, VR)
+		deque<pair<int64_t, int>> retired;	// (cycle it is free from, VR)
+		// per source register
+		vector<int> sr2vr;		// VR holding its value
+		vector<int64_t> def;	// Node in window defining it, or INVALID
+		vector<int64_t> landed;	// cycle its value lands, once def left
+		// memory order, as in Scheduler::buildDepGraph
+		int64_t lastStore, lastOutput;		// Nodes in window, or INVALID
+		int64_t storeLanded, outputLanded;	// once they have left
+		deque<int64_t> loads;	// loads since lastStore, oldest not left first
+		int64_t loadsLanded;	// latest landing of those that left
+		// list scheduler state
+		priority_queue<Entry> ready[nop + 1];	// (weight, -label)
+		priority_queue<Entry, vector<Entry>, greater<Entry>> pending; // (cycle, label)
+		Node& at(int64_t label) { return ring[label % size]; }
+		void fill();
+		void reweigh();
+		void add(Instruction in);
+		void depend(Node& n, int64_t child, int64_t landedAt);
+		int rename(int sr, bool define);
+		void leave(int64_t label, int64_t cycle);
+};